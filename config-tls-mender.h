@@ -23,3 +23,24 @@
 #undef MBEDTLS_SSL_OUT_CONTENT_LEN
 #endif
 #define MBEDTLS_SSL_OUT_CONTENT_LEN 4096
+
+/* Resumption with session tickets, for servers which do not keep a session ID cache */
+#if defined(CONFIG_MENDER_APP_TLS_SESSION_CACHE) && !defined(MBEDTLS_SSL_SESSION_TICKETS)
+#define MBEDTLS_SSL_SESSION_TICKETS
+#endif
+
+/* Per-allocation accounting for the heap statistics */
+#if defined(CONFIG_MENDER_APP_TLS_HEAP_STATS) && !defined(MBEDTLS_MEMORY_DEBUG)
+#define MBEDTLS_MEMORY_DEBUG
+#endif
+
+/* Request a maximum fragment length, the TLS sockets derive it from MBEDTLS_SSL_IN_CONTENT_LEN
+   (capped at 4096), and shrink the record buffers to what the server agreed to */
+#if defined(CONFIG_MENDER_APP_TLS_VARIABLE_BUFFERS)
+#ifndef MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#endif
+#ifndef MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+#endif
+#endif
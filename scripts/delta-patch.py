@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+"""Create and apply binary patches for the zephyr-delta Update Module.
+
+The format is described in src/utils/delta-patch.h. Example, for a signed image currently running
+on the device and a new one:
+
+    ./scripts/delta-patch.py create zephyr.signed.bin.old zephyr.signed.bin patch.bin
+    mender-artifact write module-image -T zephyr-delta -f patch.bin ...
+"""
+
+import sys
+import struct
+import hashlib
+import argparse
+
+MAGIC = b"MDLT"
+VERSION = 1
+
+# Length of the seeds used to find matches in the source
+BLOCK = 8
+# Minimum length of a match to be worth a record
+MIN_MATCH = 16
+# Max candidates considered per seed
+MAX_CANDIDATES = 16
+# A match is extended over mismatches as long as this many of the next WINDOW bytes match
+WINDOW = 16
+WINDOW_MIN_EQUAL = 8
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def svarint(value):
+    return varint((value << 1) ^ (value >> 63) if value < 0 else value << 1)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def index_source(source):
+    index = {}
+    for i in range(0, len(source) - BLOCK + 1):
+        candidates = index.setdefault(source[i : i + BLOCK], [])
+        if len(candidates) < MAX_CANDIDATES:
+            candidates.append(i)
+    return index
+
+
+def exact_length(source, s, target, t):
+    n = 0
+    limit = min(len(source) - s, len(target) - t)
+    while n < limit and source[s + n] == target[t + n]:
+        n += 1
+    return n
+
+
+def approximate_length(source, s, target, t):
+    """Extend a match over isolated differences, bsdiff style"""
+    n = exact_length(source, s, target, t)
+    limit = min(len(source) - s, len(target) - t)
+    while n < limit:
+        window = min(WINDOW, limit - n)
+        equal = sum(
+            1 for i in range(window) if source[s + n + i] == target[t + n + i]
+        )
+        if equal < min(WINDOW_MIN_EQUAL, window):
+            break
+        n += window
+        n += exact_length(source, s + n, target, t + n)
+    # Do not end on differences
+    while n > 0 and source[s + n - 1] != target[t + n - 1]:
+        n -= 1
+    return n
+
+
+def encode_copy(source, s, target, t, length):
+    """Encode a copy as (same, changed, delta bytes) pairs"""
+    out = bytearray()
+    i = 0
+    while i < length:
+        same = 0
+        while i + same < length and source[s + i + same] == target[t + i + same]:
+            same += 1
+        i += same
+        changed = 0
+        # Short runs of equal bytes are cheaper inline than a new pair
+        while i + changed < length:
+            if source[s + i + changed] != target[t + i + changed]:
+                changed += 1
+                continue
+            run = exact_length(source, s + i + changed, target, t + i + changed)
+            if run >= 3 or i + changed + run >= length:
+                break
+            changed += run
+        out += varint(same) + varint(changed)
+        out += bytes(
+            (target[t + i + k] - source[s + i + k]) & 0xFF for k in range(changed)
+        )
+        i += changed
+    return bytes(out)
+
+
+def create(source, target):
+    index = index_source(source)
+
+    # Greedy search of the longest (approximate) match at every target offset
+    matches = []
+    t = 0
+    while t <= len(target) - BLOCK:
+        best = None
+        for s in index.get(target[t : t + BLOCK], ()):
+            length = approximate_length(source, s, target, t)
+            if best is None or length > best[1]:
+                best = (s, length)
+        if best and best[1] >= MIN_MATCH:
+            matches.append((best[0], t, best[1]))
+            t += best[1]
+        else:
+            t += 1
+
+    records = bytearray()
+    if target:
+        # The decoder starts at source offset 0: the first record only holds the literal bytes
+        # before the first match and seeks to it
+        first = matches[0] if matches else (0, len(target), 0)
+        records += varint(0) + varint(first[1]) + svarint(first[0])
+        records += target[: first[1]]
+
+    # Each record is a copy followed by the literal bytes up to the next match
+    for i, (s, t, length) in enumerate(matches):
+        if i + 1 < len(matches):
+            next_s, next_t, _ = matches[i + 1]
+        else:
+            next_s, next_t = s + length, len(target)
+        insert = target[t + length : next_t]
+        records += varint(length) + varint(len(insert)) + svarint(next_s - (s + length))
+        records += encode_copy(source, s, target, t, length) + insert
+
+    header = (
+        MAGIC
+        + bytes([VERSION, 0, 0, 0])
+        + struct.pack("<II", len(source), len(target))
+        + hashlib.sha256(source).digest()
+        + hashlib.sha256(target).digest()
+    )
+    return header + bytes(records)
+
+
+def apply(source, patch):
+    if patch[0:4] != MAGIC or patch[4] != VERSION:
+        raise ValueError("Not a delta patch")
+    source_size, target_size = struct.unpack("<II", patch[8:16])
+    if len(source) < source_size:
+        raise ValueError("Source is too small")
+    source = source[:source_size]
+    if hashlib.sha256(source).digest() != patch[16:48]:
+        raise ValueError("Source does not match the patch")
+
+    target = bytearray()
+    pos = 80
+    source_pos = 0
+    while len(target) < target_size:
+        copy_len, pos = read_varint(patch, pos)
+        insert_len, pos = read_varint(patch, pos)
+        seek, pos = read_varint(patch, pos)
+        seek = (seek >> 1) ^ -(seek & 1)
+        while copy_len > 0:
+            same, pos = read_varint(patch, pos)
+            target += source[source_pos : source_pos + same]
+            source_pos += same
+            changed, pos = read_varint(patch, pos)
+            for k in range(changed):
+                target.append((source[source_pos + k] + patch[pos + k]) & 0xFF)
+            pos += changed
+            source_pos += changed
+            copy_len -= same + changed
+        source_pos += seek
+        target += patch[pos : pos + insert_len]
+        pos += insert_len
+
+    if hashlib.sha256(target).digest() != patch[48:80]:
+        raise ValueError("Target does not match the patch")
+    return bytes(target)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    create_parser = subparsers.add_parser("create", help="create a patch")
+    create_parser.add_argument("source", help="image currently on the device")
+    create_parser.add_argument("target", help="new image")
+    create_parser.add_argument("patch", help="output patch")
+
+    apply_parser = subparsers.add_parser("apply", help="apply a patch")
+    apply_parser.add_argument("source", help="image currently on the device")
+    apply_parser.add_argument("patch", help="patch")
+    apply_parser.add_argument("target", help="output image")
+
+    args = parser.parse_args()
+
+    if args.command == "create":
+        with open(args.source, "rb") as f:
+            source = f.read()
+        with open(args.target, "rb") as f:
+            target = f.read()
+        patch = create(source, target)
+        # Never ship a patch which does not apply
+        assert apply(source, patch) == target
+        with open(args.patch, "wb") as f:
+            f.write(patch)
+        print(
+            f"{len(target)} bytes target, {len(patch)} bytes patch "
+            f"({len(target) / max(len(patch), 1):.1f}x smaller)"
+        )
+    else:
+        with open(args.source, "rb") as f:
+            source = f.read()
+        with open(args.patch, "rb") as f:
+            patch = f.read()
+        with open(args.target, "wb") as f:
+            f.write(apply(source, patch))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
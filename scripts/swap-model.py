@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+"""Compare the flash cost of the MCUboot modes for an update and its revert.
+
+Each mode is replayed on a simulated flash of two slots, sector by sector, the way MCUboot moves
+the images: swap using move shifts the primary slot up by one sector then swaps, swap using offset
+swaps against an image stored one sector into the secondary slot, direct-XIP only writes the
+flags of the slots, and ram-load copies the image to RAM on every boot. The status and trailer
+writes are counted as one write block each. The simulated flash checks that the images end up
+where MCUboot would boot them from, and counts the erases of every sector.
+
+The time is estimated from the erase and write times of the board profile (typical datasheet
+values) plus hashing the image when it is validated. It only covers the bootloader, and is meant
+to compare the modes, not to replace a measurement on the board. For example:
+
+    ./scripts/swap-model.py --board nrf52840dk --image-size 300K
+"""
+
+import sys
+import json
+import argparse
+
+# sector: erase unit, block: write unit, times in ms, hash in MB/s
+BOARDS = {
+    "native_sim": {"sector": 4096, "block": 8, "erase_ms": 0.0, "write_ms": 0.0, "hash_mbps": 0.0},
+    "nrf52840dk": {"sector": 4096, "block": 4, "erase_ms": 85.0, "write_ms": 0.041, "hash_mbps": 2.0},
+    "esp32s3_devkitc": {"sector": 4096, "block": 256, "erase_ms": 45.0, "write_ms": 0.7, "hash_mbps": 10.0},
+}
+
+MODES = ("swap-using-move", "swap-using-offset", "direct-xip-with-revert", "ram-load")
+
+# Modes MCUboot can revert, the others give up rollback
+REVERTIBLE = ("swap-using-move", "swap-using-offset", "direct-xip-with-revert")
+
+
+class Flash:
+    def __init__(self, board, sectors):
+        self.board = board
+        self.slots = {"primary": [None] * sectors, "secondary": [None] * sectors}
+        self.erases = {name: [0] * sectors for name in self.slots}
+        self.writes = 0
+        self.hashed = 0
+
+    def copy(self, src_slot, src, dst_slot, dst):
+        self.erases[dst_slot][dst] += 1
+        self.slots[dst_slot][dst] = self.slots[src_slot][src]
+        self.writes += self.board["sector"] // self.board["block"]
+        # Progress of the swap, so that it can resume after a power loss
+        self.status()
+
+    def status(self):
+        self.writes += 1
+
+    def validate(self, size):
+        self.hashed += size
+
+    def time_ms(self):
+        erases = sum(sum(counts) for counts in self.erases.values())
+        hashing = self.hashed / (self.board["hash_mbps"] * 1e3) if self.board["hash_mbps"] else 0
+        return erases * self.board["erase_ms"] + self.writes * self.board["write_ms"] + hashing
+
+    def report(self):
+        return {
+            "erases": sum(sum(counts) for counts in self.erases.values()),
+            "written_bytes": self.writes * self.board["block"],
+            "max_sector_erases": max(max(counts) for counts in self.erases.values()),
+            "time_ms": round(self.time_ms(), 1),
+        }
+
+
+def swap_using_move(flash, n, size):
+    flash.validate(size)
+    # Make room: every sector of the primary slot moves up by one
+    for i in reversed(range(n)):
+        flash.copy("primary", i, "primary", i + 1)
+    for i in range(n):
+        flash.copy("secondary", i, "primary", i)
+        flash.copy("primary", i + 1, "secondary", i)
+    flash.status()
+
+
+def swap_using_offset(flash, n, size):
+    flash.validate(size)
+    # The new image starts at the second sector of the secondary slot
+    for i in range(n):
+        flash.copy("primary", i, "secondary", i)
+        flash.copy("secondary", i + 1, "primary", i)
+    flash.status()
+
+
+def revert_using_offset(flash, n, size):
+    # The old image is now at the start of the secondary slot
+    for i in reversed(range(n)):
+        flash.copy("primary", i, "secondary", i + 1)
+        flash.copy("secondary", i, "primary", i)
+    flash.status()
+
+
+def direct_xip(flash, n, size):
+    # Boots the other slot in place, once: only its flags change
+    flash.validate(size)
+    flash.status()
+
+
+def ram_load(flash, n, size):
+    # Copied to RAM and validated on every boot, nothing is written
+    flash.validate(size)
+
+
+def model(board, mode, image_size):
+    sector = board["sector"]
+    n = -(-image_size // sector)
+    flash = Flash(board, n + 1)
+
+    if mode == "swap-using-offset":
+        flash.slots["secondary"][1 : n + 1] = [("new", i) for i in range(n)]
+    else:
+        flash.slots["secondary"][:n] = [("new", i) for i in range(n)]
+    flash.slots["primary"][:n] = [("old", i) for i in range(n)]
+
+    update = {
+        "swap-using-move": swap_using_move,
+        "swap-using-offset": swap_using_offset,
+        "direct-xip-with-revert": direct_xip,
+        "ram-load": ram_load,
+    }[mode]
+    update(flash, n, image_size)
+    if mode.startswith("swap"):
+        assert flash.slots["primary"][:n] == [("new", i) for i in range(n)], mode
+    result = {"update": flash.report()}
+
+    if mode in REVERTIBLE:
+        flash = Flash(board, n + 1)
+        flash.slots["primary"][:n] = [("new", i) for i in range(n)]
+        flash.slots["secondary"][:n] = [("old", i) for i in range(n)]
+        if mode == "swap-using-move":
+            swap_using_move(flash, n, image_size)
+        elif mode == "swap-using-offset":
+            revert_using_offset(flash, n, image_size)
+        else:
+            direct_xip(flash, n, image_size)
+        if mode.startswith("swap"):
+            assert flash.slots["primary"][:n] == [("old", i) for i in range(n)], mode
+        result["revert"] = flash.report()
+    else:
+        result["revert"] = None
+    # Every boot, not only the one after an update
+    result["boot_ms"] = round(image_size / (board["hash_mbps"] * 1e3), 1) if mode == "ram-load" and board["hash_mbps"] else 0
+    return result
+
+
+def parse_size(value):
+    units = {"K": 1024, "M": 1024 * 1024}
+    if value[-1].upper() in units:
+        return int(value[:-1]) * units[value[-1].upper()]
+    return int(value, 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--board", choices=sorted(BOARDS), default="native_sim")
+    parser.add_argument("--image-size", type=parse_size, default=256 * 1024, help="e.g. 300K")
+    parser.add_argument("--json", action="store_true", help="print the report as JSON")
+    args = parser.parse_args()
+
+    board = BOARDS[args.board]
+    report = {mode: model(board, mode, args.image_size) for mode in MODES}
+
+    if args.json:
+        json.dump({"board": args.board, "image_size": args.image_size, "modes": report}, sys.stdout, indent=2)
+        print()
+        return
+
+    print(f"{args.board}, {args.image_size} bytes image")
+    print(f"{'mode':<24}{'update ms':>12}{'erases':>9}{'max/sector':>12}{'revert ms':>12}")
+    for mode, result in report.items():
+        update, revert = result["update"], result["revert"]
+        print(
+            f"{mode:<24}{update['time_ms']:>12}{update['erases']:>9}{update['max_sector_erases']:>12}"
+            f"{revert['time_ms'] if revert else 'no revert':>12}"
+        )
+
+
+if __name__ == "__main__":
+    main()
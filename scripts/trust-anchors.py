@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+"""Reduce root certificates to compact trust anchors.
+
+A root certificate is only used for its subject, its public key and its CA constraints: mbedTLS
+never checks the signature of a trusted root, and ignores most of its extensions. Each anchor is
+rewritten as a certificate keeping the subject, the key, the validity and the basicConstraints,
+keyUsage, nameConstraints and critical extensions, with an empty signature. This saves flash, and
+heap and parsing time on every handshake since the TLS layer parses the anchors for every socket.
+
+Only CA certificates are reduced. mbedTLS trusts a leaf certificate, like the self-signed one of
+an on-prem server, by comparing it byte for byte with the one the server sends, so anything else
+is kept as is. Anchors with the same subject and key as a previous one are dropped. Used by
+CMakeLists.txt, for example:
+
+    ./scripts/trust-anchors.py AmazonRootCA1.der:primary.der GTSR4.der:secondary.der
+"""
+
+import os
+import sys
+import base64
+import hashlib
+import argparse
+
+TAG_SEQUENCE = 0x30
+TAG_BIT_STRING = 0x03
+TAG_EXTENSIONS = 0xA3
+TAG_BOOLEAN = 0x01
+
+BASIC_CONSTRAINTS = bytes.fromhex("551d13")
+
+# Extensions mbedTLS looks at on a trusted CA
+KEPT_EXTENSIONS = {
+    BASIC_CONSTRAINTS,  # basicConstraints, 2.5.29.19
+    bytes.fromhex("551d0f"),  # keyUsage, 2.5.29.15
+    bytes.fromhex("551d1e"),  # nameConstraints, 2.5.29.30
+}
+
+# Smallest signature mbedTLS accepts: no unused bits, one byte
+EMPTY_SIGNATURE = bytes([TAG_BIT_STRING, 0x02, 0x00, 0x00])
+
+
+def read_tlv(data, pos):
+    """Return the tag, the start and the end of the value of the element at pos"""
+    tag = data[pos]
+    length = data[pos + 1]
+    pos += 2
+    if length & 0x80:
+        count = length & 0x7F
+        length = int.from_bytes(data[pos : pos + count], "big")
+        pos += count
+    if pos + length > len(data):
+        raise ValueError("truncated element")
+    return tag, pos, pos + length
+
+
+def elements(data, start, end):
+    """Return the encoded elements between start and end"""
+    out = []
+    while start < end:
+        _, value, next_start = read_tlv(data, start)
+        out.append(data[start:next_start])
+        start = next_start
+    return out
+
+
+def encode(tag, value):
+    length = len(value)
+    if length < 0x80:
+        return bytes([tag, length]) + value
+    count = (length.bit_length() + 7) // 8
+    return bytes([tag, 0x80 | count]) + length.to_bytes(count, "big") + value
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if b"-----BEGIN CERTIFICATE-----" in data:
+        text = data.split(b"-----BEGIN CERTIFICATE-----")[1]
+        text = text.split(b"-----END CERTIFICATE-----")[0]
+        data = base64.b64decode(b"".join(text.split()))
+    return data
+
+
+def is_ca(ext):
+    """Whether the extensions have basicConstraints with cA set"""
+    _, start, end = read_tlv(ext, 0)
+    _, start, end = read_tlv(ext, start)
+    for extension in elements(ext, start, end):
+        _, value, value_end = read_tlv(extension, 0)
+        fields = elements(extension, value, value_end)
+        _, oid, oid_end = read_tlv(fields[0], 0)
+        if fields[0][oid:oid_end] != BASIC_CONSTRAINTS:
+            continue
+        # OCTET STRING holding SEQUENCE { cA BOOLEAN DEFAULT FALSE, pathLenConstraint }
+        _, octets, octets_end = read_tlv(fields[-1], 0)
+        _, start, end = read_tlv(fields[-1], octets)
+        constraints = elements(fields[-1], start, end)
+        return (
+            bool(constraints)
+            and constraints[0][0] == TAG_BOOLEAN
+            and constraints[0][2:] != b"\x00"
+        )
+    return False
+
+
+def compact_extensions(ext):
+    """Keep the extensions which matter on a trusted CA, and the critical ones"""
+    _, start, end = read_tlv(ext, 0)
+    _, start, end = read_tlv(ext, start)
+    kept = []
+    for extension in elements(ext, start, end):
+        _, value, value_end = read_tlv(extension, 0)
+        fields = elements(extension, value, value_end)
+        _, oid, oid_end = read_tlv(fields[0], 0)
+        critical = len(fields) == 3 and fields[1] == bytes([0x01, 0x01, 0xFF])
+        if critical or fields[0][oid:oid_end] in KEPT_EXTENSIONS:
+            kept.append(extension)
+    if not kept:
+        return b""
+    return encode(TAG_EXTENSIONS, encode(TAG_SEQUENCE, b"".join(kept)))
+
+
+def compact(cert):
+    """Return the compact anchor, None if the certificate is not a CA, and the key identifying it"""
+    tag, start, end = read_tlv(cert, 0)
+    if tag != TAG_SEQUENCE or end != len(cert):
+        raise ValueError("not a DER certificate")
+    tbs, signature_algorithm, _ = elements(cert, start, end)
+
+    _, start, end = read_tlv(tbs, 0)
+    fields = elements(tbs, start, end)
+    # version, serial, signature, issuer, validity, subject, subjectPublicKeyInfo, [extensions]
+    if fields[0][0] != 0xA0:
+        # X.509 v1, without extensions to tell if it is a CA
+        return None, hashlib.sha256(cert).digest()
+    if len(fields) < 7:
+        raise ValueError("not an X.509 certificate")
+    subject, key = fields[5], fields[6]
+    identity = hashlib.sha256(subject + key).digest()
+    extensions = b""
+    for field in fields[7:]:
+        if field[0] == TAG_EXTENSIONS:
+            if not is_ca(field):
+                return None, identity
+            extensions = compact_extensions(field)
+    if not extensions:
+        return None, identity
+
+    tbs = encode(TAG_SEQUENCE, b"".join(fields[:7]) + extensions)
+    anchor = encode(TAG_SEQUENCE, tbs + signature_algorithm + EMPTY_SIGNATURE)
+    return anchor, identity
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument(
+        "certificates",
+        nargs="+",
+        metavar="INPUT:OUTPUT",
+        help="DER or PEM certificate and the file to write its anchor to",
+    )
+    args = parser.parse_args()
+
+    seen = {}
+    size_in = size_out = 0
+    for arg in args.certificates:
+        path_in, path_out = arg.rsplit(":", 1)
+        cert = load(path_in)
+        anchor, key = compact(cert)
+        size_in += len(cert)
+
+        # A duplicate has no output, stale ones from a previous selection are removed
+        if key in seen:
+            print(f"{path_in}: same anchor as {seen[key]}")
+            if os.path.exists(path_out):
+                os.remove(path_out)
+            continue
+        seen[key] = path_in
+
+        if anchor is None:
+            print(f"{path_in}: not a CA certificate, kept as is")
+            anchor = cert
+        else:
+            print(f"{path_in}: {len(cert)} -> {len(anchor)} bytes")
+        size_out += len(anchor)
+
+        with open(path_out, "wb") as f:
+            f.write(anchor)
+
+    print(f"Trust anchors: {size_in} -> {size_out} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
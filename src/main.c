@@ -18,8 +18,11 @@ LOG_MODULE_REGISTER(mender_app, LOG_LEVEL_DBG);
 #include "utils/callbacks.h"
 #include "utils/netup.h"
 #include "utils/certs.h"
+#include "utils/profiler.h"
+#include "utils/event-trace.h"
 
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/reboot.h>
 
 #include <mender/utils.h>
@@ -28,17 +31,66 @@ LOG_MODULE_REGISTER(mender_app, LOG_LEVEL_DBG);
 
 #ifdef BUILD_INTEGRATION_TESTS
 #include "modules/test-update-module.h"
+#include "modules/bench-update-module.h"
 #include "test_definitions.h"
 #endif /* BUILD_INTEGRATION_TESTS */
 
 #ifdef CONFIG_MENDER_ZEPHYR_IMAGE_UPDATE_MODULE
 #include <mender/zephyr-image-update-module.h>
+#ifdef CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP
+/* It writes the new image to the secondary slot and confirms the primary one */
+#error "The zephyr-image Update Module only supports the MCUboot swap modes, use zephyr-delta for direct-XIP"
+#endif /* CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP */
 #endif /* CONFIG_MENDER_ZEPHYR_IMAGE_UPDATE_MODULE */
 
 #ifdef CONFIG_MENDER_APP_NOOP_UPDATE_MODULE
 #include "modules/noop-update-module.h"
 #endif /* CONFIG_MENDER_APP_NOOP_UPDATE_MODULE */
 
+#ifdef CONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE
+#include "modules/raw-partition-update-module.h"
+#endif /* CONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE */
+
+#ifdef CONFIG_MENDER_APP_DELTA_UPDATE_MODULE
+#include "modules/delta-update-module.h"
+#endif /* CONFIG_MENDER_APP_DELTA_UPDATE_MODULE */
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_HASH
+#include "utils/download-hash.h"
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_HASH */
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS
+#include "utils/download-decompress.h"
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS */
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_PIPELINE
+#include "utils/download-pipeline.h"
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_PIPELINE */
+
+#ifdef CONFIG_MENDER_APP_MEM_POOL
+#include "utils/mem-pool.h"
+#endif /* CONFIG_MENDER_APP_MEM_POOL */
+
+#ifdef CONFIG_MENDER_APP_INVENTORY_AGG
+#include "utils/inventory-agg.h"
+#endif /* CONFIG_MENDER_APP_INVENTORY_AGG */
+
+#ifdef CONFIG_MENDER_APP_POLL_SCHED
+#include "utils/poll-sched.h"
+#endif /* CONFIG_MENDER_APP_POLL_SCHED */
+
+#ifdef CONFIG_MENDER_APP_STATUS_JOURNAL
+#include "utils/status-journal.h"
+#endif /* CONFIG_MENDER_APP_STATUS_JOURNAL */
+
+#ifdef CONFIG_MENDER_APP_AUTH_CACHE
+#include "utils/auth-cache.h"
+#endif /* CONFIG_MENDER_APP_AUTH_CACHE */
+
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG
+#include "utils/deploy-log.h"
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG */
+
 #ifdef CONFIG_MENDER_CLIENT_INVENTORY_DISABLE
 #error Mender MCU integration app requires the inventory feature
 #endif /* CONFIG_MENDER_CLIENT_INVENTORY_DISABLE */
@@ -70,6 +122,78 @@ mender_restart_cb(void) {
     return MENDER_OK;
 }
 
+/* Wrap the connect and release callbacks, which may be overridden, to manage the interface and
+   time the first poll */
+static mender_err_t
+network_connect_cb(void) {
+    event_trace_emit(EVENT_TRACE_NETWORK, 1, 0);
+#ifdef CONFIG_MENDER_APP_NETWORK_ON_DEMAND
+    if (0 != netup_connect()) {
+        return MENDER_FAIL;
+    }
+    if (MENDER_OK != mender_network_connect_cb()) {
+        netup_release();
+        return MENDER_FAIL;
+    }
+    return MENDER_OK;
+#else
+    return mender_network_connect_cb();
+#endif /* CONFIG_MENDER_APP_NETWORK_ON_DEMAND */
+}
+
+static mender_err_t
+network_release_cb(void) {
+    mender_err_t ret = mender_network_release_cb();
+
+    event_trace_emit(EVENT_TRACE_NETWORK, 0, 0);
+    profiler_mark(PROFILER_PHASE_FIRST_POLL);
+#ifdef CONFIG_MENDER_APP_NETWORK_ON_DEMAND
+    netup_release();
+#endif /* CONFIG_MENDER_APP_NETWORK_ON_DEMAND */
+    return ret;
+}
+
+/* Wrap the deployment status callback, which may be overridden, to journal the transitions and
+   scope the allocations and the logs of a deployment */
+static mender_err_t
+deployment_status_cb(mender_deployment_status_t status, const char *desc) {
+    event_trace_emit(EVENT_TRACE_DEPLOYMENT_STATUS, status, 0);
+#ifdef CONFIG_MENDER_APP_STATUS_JOURNAL
+    status_journal_record(status);
+#endif /* CONFIG_MENDER_APP_STATUS_JOURNAL */
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG
+    switch (status) {
+        case MENDER_DEPLOYMENT_STATUS_DOWNLOADING:
+            deploy_log_begin();
+            break;
+        case MENDER_DEPLOYMENT_STATUS_SUCCESS:
+        case MENDER_DEPLOYMENT_STATUS_ALREADY_INSTALLED:
+            deploy_log_end(false);
+            break;
+        case MENDER_DEPLOYMENT_STATUS_FAILURE:
+            deploy_log_end(true);
+            break;
+        default:
+            break;
+    }
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG */
+#ifdef CONFIG_MENDER_APP_MEM_POOL
+    switch (status) {
+        case MENDER_DEPLOYMENT_STATUS_DOWNLOADING:
+            mem_pool_deployment_begin();
+            break;
+        case MENDER_DEPLOYMENT_STATUS_SUCCESS:
+        case MENDER_DEPLOYMENT_STATUS_FAILURE:
+        case MENDER_DEPLOYMENT_STATUS_ALREADY_INSTALLED:
+            mem_pool_deployment_end();
+            break;
+        default:
+            break;
+    }
+#endif /* CONFIG_MENDER_APP_MEM_POOL */
+    return mender_deployment_status_cb(status, desc);
+}
+
 static char              mac_address[18] = { 0 };
 static mender_identity_t mender_identity = { .name = "mac", .value = mac_address };
 
@@ -83,6 +207,84 @@ mender_get_identity_cb(const mender_identity_t **identity) {
     return MENDER_FAIL;
 }
 
+/* Artifact types of the Update Modules registered below, NULL terminated */
+static const char *update_module_types[] __maybe_unused = {
+#ifdef CONFIG_MENDER_ZEPHYR_IMAGE_UPDATE_MODULE
+    "zephyr-image",
+#endif /* CONFIG_MENDER_ZEPHYR_IMAGE_UPDATE_MODULE */
+#ifdef CONFIG_MENDER_APP_NOOP_UPDATE_MODULE
+    "noop-update",
+#endif /* CONFIG_MENDER_APP_NOOP_UPDATE_MODULE */
+#ifdef CONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE
+    "raw-partition",
+#endif /* CONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE */
+#ifdef CONFIG_MENDER_APP_DELTA_UPDATE_MODULE
+    "zephyr-delta",
+#endif /* CONFIG_MENDER_APP_DELTA_UPDATE_MODULE */
+#ifdef BUILD_INTEGRATION_TESTS
+    "test-update",
+    "bench-update",
+#endif /* BUILD_INTEGRATION_TESTS */
+    NULL,
+};
+
+/* Every stage wrapping them has one trampoline per Update Module */
+BUILD_ASSERT(ARRAY_SIZE(update_module_types) - 1 <= CONFIG_MENDER_APP_UPDATE_MODULES_MAX,
+             "More Update Modules than CONFIG_MENDER_APP_UPDATE_MODULES_MAX");
+
+/* The client is activated once both the network is up and the initialization is done, whichever
+   comes last, from the system work queue */
+#define STARTUP_NETWORK_READY BIT(0)
+#define STARTUP_CLIENT_READY  BIT(1)
+#define STARTUP_READY         (STARTUP_NETWORK_READY | STARTUP_CLIENT_READY)
+
+static atomic_t startup_state = ATOMIC_INIT(0);
+
+static void
+activate_work_handler(struct k_work *work) {
+    ARG_UNUSED(work);
+
+    if (MENDER_OK != mender_client_activate()) {
+        LOG_ERR("Unable to activate the client");
+        return;
+    }
+    LOG_INF("Mender client activated and running!");
+    profiler_mark(PROFILER_PHASE_ACTIVATE);
+
+#ifdef CONFIG_MENDER_APP_POLL_SCHED
+    if (MENDER_OK != poll_sched_start()) {
+        LOG_ERR("Unable to start the poll scheduler");
+    }
+#endif /* CONFIG_MENDER_APP_POLL_SCHED */
+}
+
+#ifdef CONFIG_MENDER_APP_POLL_SCHED
+/* Delayed by a fraction of the startup spread, specific to the device */
+static K_WORK_DELAYABLE_DEFINE(activate_work, activate_work_handler);
+#else
+static K_WORK_DEFINE(activate_work, activate_work_handler);
+#endif /* CONFIG_MENDER_APP_POLL_SCHED */
+
+static void
+startup_ready(atomic_val_t ready) {
+    atomic_val_t previous = atomic_or(&startup_state, ready);
+
+    /* Only the last one to get ready activates, and only once */
+    if ((STARTUP_READY != previous) && (STARTUP_READY == (previous | ready))) {
+#ifdef CONFIG_MENDER_APP_POLL_SCHED
+        k_work_schedule(&activate_work, K_SECONDS(poll_sched_startup_delay()));
+#else
+        k_work_submit(&activate_work);
+#endif /* CONFIG_MENDER_APP_POLL_SCHED */
+    }
+}
+
+static void
+network_ready_cb(void) {
+    profiler_mark(PROFILER_PHASE_NETWORK);
+    startup_ready(STARTUP_NETWORK_READY);
+}
+
 static mender_err_t
 persistent_inventory_cb(mender_keystore_t **keystore, uint8_t *keystore_len) {
     static mender_keystore_t inventory[] = { { .name = "App", .value = "mender-mcu-integration" } };
@@ -93,19 +295,39 @@ persistent_inventory_cb(mender_keystore_t **keystore, uint8_t *keystore_len) {
 
 int
 main(void) {
+    profiler_mark(PROFILER_PHASE_KERNEL);
+
     printf("Hello World! %s\n", CONFIG_BOARD_TARGET);
 
-    netup_wait_for_network();
+    if (MENDER_OK != event_trace_init()) {
+        LOG_ERR("Failed to start the event trace");
+        goto END;
+    }
+
+    /* Everything below until the activation does not need the network */
+    if (0 != netup_start(network_ready_cb)) {
+        LOG_ERR("Failed to start the network");
+        goto END;
+    }
 
     netup_get_mac_address(mender_identity.value);
+#ifdef CONFIG_MENDER_APP_POLL_SCHED
+    /* The identity the server knows the device by, which the application may override */
+    const mender_identity_t *identity;
+    if ((MENDER_OK != mender_get_identity_cb(&identity)) || (MENDER_OK != poll_sched_init(identity))) {
+        LOG_ERR("Failed to initialize the poll scheduler");
+        goto END;
+    }
+#endif /* CONFIG_MENDER_APP_POLL_SCHED */
 
     certs_add_credentials();
+    profiler_mark(PROFILER_PHASE_CERTS);
 
     /* Initialize mender-client */
     mender_client_config_t    mender_client_config    = { .device_type = CONFIG_MENDER_DEVICE_TYPE, .recommissioning = false };
-    mender_client_callbacks_t mender_client_callbacks = { .network_connect        = mender_network_connect_cb,
-                                                          .network_release        = mender_network_release_cb,
-                                                          .deployment_status      = mender_deployment_status_cb,
+    mender_client_callbacks_t mender_client_callbacks = { .network_connect        = network_connect_cb,
+                                                          .network_release        = network_release_cb,
+                                                          .deployment_status      = deployment_status_cb,
                                                           .restart                = mender_restart_cb,
                                                           .get_identity           = mender_get_identity_cb,
                                                           .get_user_provided_keys = NULL };
@@ -114,11 +336,19 @@ main(void) {
     LOG_INF("   Device type:   '%s'", mender_client_config.device_type);
     LOG_INF("   Identity:      '{\"%s\": \"%s\"}'", mender_identity.name, mender_identity.value);
 
+#ifdef CONFIG_MENDER_APP_MEM_POOL
+    if (MENDER_OK != mem_pool_init()) {
+        LOG_ERR("Failed to set the allocator");
+        goto END;
+    }
+#endif /* CONFIG_MENDER_APP_MEM_POOL */
+
     if (MENDER_OK != mender_client_init(&mender_client_config, &mender_client_callbacks)) {
         LOG_ERR("Failed to initialize the client");
         goto END;
     }
     LOG_INF("Mender client initialized");
+    profiler_mark(PROFILER_PHASE_CLIENT_INIT);
 
 #ifdef CONFIG_MENDER_ZEPHYR_IMAGE_UPDATE_MODULE
     if (MENDER_OK != mender_zephyr_image_register_update_module()) {
@@ -136,26 +366,138 @@ main(void) {
     LOG_INF("Update Module 'noop-update' initialized");
 #endif /* CONFIG_MENDER_APP_NOOP_UPDATE_MODULE */
 
+#ifdef CONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE
+    if (MENDER_OK != raw_partition_update_module_register()) {
+        LOG_ERR("Failed to register the raw-partition Update Module");
+        goto END;
+    }
+    LOG_INF("Update Module 'raw-partition' initialized");
+#endif /* CONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE */
+
+#ifdef CONFIG_MENDER_APP_DELTA_UPDATE_MODULE
+    if (MENDER_OK != delta_update_module_register()) {
+        LOG_ERR("Failed to register the zephyr-delta Update Module");
+        goto END;
+    }
+    LOG_INF("Update Module 'zephyr-delta' initialized");
+#endif /* CONFIG_MENDER_APP_DELTA_UPDATE_MODULE */
+
 #ifdef BUILD_INTEGRATION_TESTS
     if (MENDER_OK != test_update_module_register()) {
         LOG_ERR("Failed to register the test Update Module");
         goto END;
     }
     LOG_INF("Update Module 'test-update' initialized");
+
+    if (MENDER_OK != bench_update_module_register()) {
+        LOG_ERR("Failed to register the bench Update Module");
+        goto END;
+    }
+    LOG_INF("Update Module 'bench-update' initialized");
 #endif /* BUILD_INTEGRATION_TESTS */
 
+    /* Download stages, the first one added is the closest to the Update Module */
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_HASH
+    for (size_t i = 0; NULL != update_module_types[i]; i++) {
+        if (MENDER_OK != download_hash_wrap(update_module_types[i])) {
+            LOG_ERR("Failed to add payload hashing to '%s'", update_module_types[i]);
+            goto END;
+        }
+    }
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_HASH */
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS
+    for (size_t i = 0; NULL != update_module_types[i]; i++) {
+        if (MENDER_OK != download_decompress_wrap(update_module_types[i])) {
+            LOG_ERR("Failed to add payload decompression to '%s'", update_module_types[i]);
+            goto END;
+        }
+    }
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS */
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_PIPELINE
+    /* Added last so that the other stages run on the writer thread too */
+    for (size_t i = 0; NULL != update_module_types[i]; i++) {
+        if (MENDER_OK != download_pipeline_wrap(update_module_types[i])) {
+            LOG_ERR("Failed to add the download pipeline to '%s'", update_module_types[i]);
+            goto END;
+        }
+    }
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_PIPELINE */
+
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG
+    for (size_t i = 0; NULL != update_module_types[i]; i++) {
+        if (MENDER_OK != deploy_log_wrap(update_module_types[i])) {
+            LOG_ERR("Failed to capture the logs of '%s'", update_module_types[i]);
+            goto END;
+        }
+    }
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG */
+
+#ifdef CONFIG_MENDER_APP_STATUS_JOURNAL
+    /* Around the captured logs, which replace the stored ones */
+    for (size_t i = 0; NULL != update_module_types[i]; i++) {
+        if (MENDER_OK != status_journal_wrap(update_module_types[i])) {
+            LOG_ERR("Failed to journal '%s'", update_module_types[i]);
+            goto END;
+        }
+    }
+#endif /* CONFIG_MENDER_APP_STATUS_JOURNAL */
+
+#ifdef CONFIG_MENDER_APP_EVENT_TRACE
+    /* Outermost, to see the data as the client receives it */
+    for (size_t i = 0; NULL != update_module_types[i]; i++) {
+        if (MENDER_OK != event_trace_wrap(update_module_types[i])) {
+            LOG_ERR("Failed to trace '%s'", update_module_types[i]);
+            goto END;
+        }
+    }
+#endif /* CONFIG_MENDER_APP_EVENT_TRACE */
+
+#ifdef CONFIG_MENDER_APP_INVENTORY_AGG
+    /* Only sent when changed, or every CONFIG_MENDER_CLIENT_INVENTORY_REFRESH_INTERVAL seconds. The
+       App attribute never changes, the callbacks of data which does are added the same way */
+    if ((MENDER_OK != inventory_agg_add_callback(persistent_inventory_cb)) || (MENDER_OK != inventory_agg_start())) {
+        LOG_ERR("Failed to add inventory callback");
+        goto END;
+    }
+#else
     if (MENDER_OK != mender_inventory_add_callback(persistent_inventory_cb, true)) {
         LOG_ERR("Failed to add inventory callback");
         goto END;
     }
+#endif /* CONFIG_MENDER_APP_INVENTORY_AGG */
     LOG_INF("Mender inventory callback added");
+    profiler_mark(PROFILER_PHASE_MODULES);
 
-    /* Finally activate mender client */
-    if (MENDER_OK != mender_client_activate()) {
-        LOG_ERR("Unable to activate the client");
+    if (MENDER_OK != profiler_add_inventory()) {
+        LOG_ERR("Failed to add the boot profile inventory callback");
         goto END;
     }
-    LOG_INF("Mender client activated and running!");
+
+#ifdef CONFIG_MENDER_APP_MEM_POOL
+    if (MENDER_OK != mem_pool_add_inventory()) {
+        LOG_ERR("Failed to add the allocator inventory callback");
+        goto END;
+    }
+#endif /* CONFIG_MENDER_APP_MEM_POOL */
+
+#ifdef CONFIG_MENDER_APP_STATUS_JOURNAL
+    if (MENDER_OK != status_journal_init()) {
+        LOG_ERR("Failed to initialize the deployment journal");
+        goto END;
+    }
+#endif /* CONFIG_MENDER_APP_STATUS_JOURNAL */
+
+#ifdef CONFIG_MENDER_APP_AUTH_CACHE
+    if (MENDER_OK != auth_cache_init()) {
+        LOG_ERR("Failed to initialize the authentication token cache");
+        goto END;
+    }
+#endif /* CONFIG_MENDER_APP_AUTH_CACHE */
+
+    /* Finally activate mender client, as soon as the network is up */
+    startup_ready(STARTUP_CLIENT_READY);
 
 END:
     k_sleep(K_FOREVER);
@@ -0,0 +1,330 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <mender/alloc.h>
+#include <mender/client.h>
+#include <mender/log.h>
+#include <mender/utils.h>
+#include <mender/update-module.h>
+
+#include "delta-update-module.h"
+#include "utils/delta-patch.h"
+#include "utils/mcuboot-slot.h"
+
+#include <string.h>
+
+#include <mbedtls/sha256.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/dfu/flash_img.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/util.h>
+
+/* The 'zephyr-delta' Update Module rebuilds the new image from the running one and a binary
+ * patch, while the patch is being downloaded. The patch header carries the SHA-256 of both
+ * images: the running image is checked before anything is written, the result is hashed while it
+ * is written and checked once the patch is complete. From there on, the flow is the same as for
+ * the zephyr-image Update Module: the new image is booted in test mode, confirmed on commit and
+ * reverted by MCUboot if the device reboots before that.
+ *
+ * The slots depend on the MCUboot mode, see utils/mcuboot-slot.h. In direct-XIP mode the patch
+ * has to produce the image linked for the slot the device is not running from. */
+
+static mender_err_t delta_update_module_download(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t delta_update_module_install(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t delta_update_module_verify_reboot(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t delta_update_module_commit(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t delta_update_module_rollback(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t delta_update_module_rollback_verify_reboot(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t delta_update_module_failure(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static const struct flash_area *delta_source_fa;
+static struct flash_img_context delta_target;
+static mbedtls_sha256_context   delta_target_sha256;
+static delta_patch_t            delta_patch;
+static size_t                   delta_header_received;
+static bool                     delta_complete;
+
+static int
+delta_read_source(MENDER_ARG_UNUSED void *ctx, size_t offset, uint8_t *buf, size_t len) {
+    return flash_area_read(delta_source_fa, offset, buf, len);
+}
+
+static int
+delta_write_target(MENDER_ARG_UNUSED void *ctx, const uint8_t *buf, size_t len) {
+    /* Hash the result on the way to flash, so it does not have to be read back */
+    mbedtls_sha256_update(&delta_target_sha256, buf, len);
+    return flash_img_buffered_write(&delta_target, buf, len, false);
+}
+
+static void
+delta_close(void) {
+    if (NULL != delta_source_fa) {
+        flash_area_close(delta_source_fa);
+        mbedtls_sha256_free(&delta_target_sha256);
+        delta_source_fa = NULL;
+    }
+}
+
+static mender_err_t
+delta_open(void) {
+    int rc;
+
+    delta_close();
+    delta_complete        = false;
+    delta_header_received = 0;
+    mbedtls_sha256_init(&delta_target_sha256);
+    mbedtls_sha256_starts(&delta_target_sha256, 0);
+
+    if (0 != (rc = flash_area_open(mcuboot_slot_active_id(), &delta_source_fa))) {
+        mender_log_error("Unable to open the running slot: %d", rc);
+        delta_source_fa = NULL;
+        return MENDER_FAIL;
+    }
+    /* The target slot still holds the previous image, it is erased page by page ahead of the
+     * writes, and its trailer on the final flush (IMG_ERASE_PROGRESSIVELY) */
+    if (0 != (rc = flash_img_init_id(&delta_target, mcuboot_slot_target_id()))) {
+        mender_log_error("Unable to open the target slot: %d", rc);
+        delta_close();
+        return MENDER_FAIL;
+    }
+    delta_patch_init(&delta_patch, delta_read_source, delta_write_target, NULL);
+
+    return MENDER_OK;
+}
+
+/* Make sure the patch was made for the image we are running and that the result fits */
+static mender_err_t
+delta_check_header(const delta_patch_header_t *header) {
+    uint8_t rbuf[64];
+    int     rc;
+
+    if (header->source_size > delta_source_fa->fa_size) {
+        mender_log_error("Patch source of %u bytes is bigger than the running slot", header->source_size);
+        return MENDER_FAIL;
+    }
+    if (header->target_size > delta_target.flash_area->fa_size) {
+        mender_log_error("Patch target of %u bytes does not fit into the target slot", header->target_size);
+        return MENDER_FAIL;
+    }
+
+    struct flash_area_check fac = {
+        .match = header->source_sha256,
+        .clen  = header->source_size,
+        .off   = 0,
+        .rbuf  = rbuf,
+        .rblen = sizeof(rbuf),
+    };
+    if (0 != (rc = flash_area_check_int_sha256(delta_source_fa, &fac))) {
+        mender_log_error("The patch does not apply to the running image: %d", rc);
+        return MENDER_FAIL;
+    }
+
+    mender_log_info("Applying patch: %u bytes image from %u bytes image", header->target_size, header->source_size);
+
+    return MENDER_OK;
+}
+
+mender_err_t
+delta_update_module_register(void) {
+    mender_err_t            ret;
+    mender_update_module_t *delta_update_module;
+
+    /* Register the zephyr-delta update module */
+    if (NULL == (delta_update_module = mender_calloc(1, sizeof(mender_update_module_t)))) {
+        mender_log_error("Unable to allocate memory for the 'zephyr-delta' update module");
+        return MENDER_FAIL;
+    }
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_DOWNLOAD]               = &delta_update_module_download;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_INSTALL]                = &delta_update_module_install;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_REBOOT]                 = NULL;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_VERIFY_REBOOT]          = &delta_update_module_verify_reboot;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_COMMIT]                 = &delta_update_module_commit;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK]               = &delta_update_module_rollback;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_FAILURE]                = &delta_update_module_failure;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK_REBOOT]        = NULL;
+    delta_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT] = &delta_update_module_rollback_verify_reboot;
+    delta_update_module->artifact_type                                         = "zephyr-delta";
+    delta_update_module->requires_reboot                                       = true;
+    delta_update_module->supports_rollback                                     = true;
+
+    if (MENDER_OK != (ret = mender_update_module_register(delta_update_module))) {
+        mender_log_error("Unable to register the 'zephyr-delta' update module");
+        /* mender_update_module_register() takes ownership if it succeeds */
+        mender_free(delta_update_module);
+        return ret;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_update_module_download(MENDER_NDEBUG_UNUSED mender_update_state_t state, mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_DOWNLOAD == state);
+
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+    const uint8_t                              *data    = dl_data->data;
+    size_t                                      length  = dl_data->length;
+    int                                         rc;
+
+    if (NULL == dl_data->filename) {
+        return MENDER_OK;
+    }
+
+    if ((0 == dl_data->offset) && (MENDER_OK != delta_open())) {
+        return MENDER_FAIL;
+    }
+    if (NULL == delta_source_fa) {
+        mender_log_error("The patch download was not started");
+        return MENDER_FAIL;
+    }
+
+    /* Feed the header on its own, the source must be checked before the patch reads from it */
+    if (delta_header_received < DELTA_PATCH_HEADER_SIZE) {
+        size_t n = MIN(length, DELTA_PATCH_HEADER_SIZE - delta_header_received);
+        if (0 != (rc = delta_patch_process(&delta_patch, data, n))) {
+            mender_log_error("Invalid patch header: %d", rc);
+            return MENDER_FAIL;
+        }
+        delta_header_received += n;
+        data += n;
+        length -= n;
+
+        if (DELTA_PATCH_HEADER_SIZE == delta_header_received) {
+            if (MENDER_OK != delta_check_header(delta_patch_get_header(&delta_patch))) {
+                return MENDER_FAIL;
+            }
+        }
+    }
+
+    if (0 != (rc = delta_patch_process(&delta_patch, data, length))) {
+        mender_log_error("Unable to apply the patch at offset %zu: %d", dl_data->offset, rc);
+        return MENDER_FAIL;
+    }
+
+    if (dl_data->done) {
+        const delta_patch_header_t *header = delta_patch_get_header(&delta_patch);
+        if ((NULL == header) || !delta_patch_is_done(&delta_patch)) {
+            mender_log_error("The patch is truncated");
+            return MENDER_FAIL;
+        }
+        if (0 != (rc = flash_img_buffered_write(&delta_target, NULL, 0, true))) {
+            mender_log_error("Unable to write the target slot: %d", rc);
+            return MENDER_FAIL;
+        }
+
+        /* The patch is only as good as the source it was made for */
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&delta_target_sha256, digest);
+        if (0 != memcmp(digest, header->target_sha256, sizeof(digest))) {
+            mender_log_error("The patched image does not match the expected checksum");
+            return MENDER_FAIL;
+        }
+
+        delta_close();
+        delta_complete = true;
+        mender_log_info("Patch applied, %u bytes written to the target slot", header->target_size);
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_update_module_install(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_INSTALL == state);
+
+    if (!delta_complete) {
+        mender_log_error("The patch has not been completely applied");
+        return MENDER_FAIL;
+    }
+    if (0 != mcuboot_slot_request_test()) {
+        mender_log_error("Unable to mark the new image as pending");
+        return MENDER_FAIL;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_update_module_verify_reboot(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_VERIFY_REBOOT == state);
+
+    /* A confirmed image means that MCUboot did not boot the new one */
+    if (mcuboot_slot_is_confirmed()) {
+        mender_log_error("The new image has not been booted");
+        return MENDER_FAIL;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_update_module_commit(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_COMMIT == state);
+
+    if (0 != mcuboot_slot_confirm()) {
+        mender_log_error("Unable to confirm the new image");
+        return MENDER_FAIL;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_cancel_pending(void) {
+    delta_close();
+    delta_complete = false;
+
+    /* Still running the confirmed image: make sure MCUboot does not pick up the new one */
+    if (mcuboot_slot_is_confirmed() && (0 != mcuboot_slot_erase_target())) {
+        mender_log_error("Unable to erase the target slot");
+        return MENDER_FAIL;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_update_module_rollback(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_ROLLBACK == state);
+
+    /* If the new image is running, MCUboot reverts it on the next reboot since it is not confirmed */
+    return delta_cancel_pending();
+}
+
+static mender_err_t
+delta_update_module_rollback_verify_reboot(MENDER_NDEBUG_UNUSED mender_update_state_t state,
+                                           MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT == state);
+
+    if (!mcuboot_slot_is_confirmed()) {
+        mender_log_error("The previous image has not been restored");
+        return MENDER_FAIL;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+delta_update_module_failure(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_FAILURE == state);
+
+    return delta_cancel_pending();
+}
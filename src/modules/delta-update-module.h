@@ -0,0 +1,36 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DELTA_UPDATE_MODULE_H__
+#define __DELTA_UPDATE_MODULE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <mender/utils.h>
+
+/**
+ * @brief Register the 'zephyr-delta' Update Module
+ * @note The payload is a binary patch (see scripts/delta-patch.py) which is applied to the running
+ *       image while downloading, the result is written to the other MCUboot slot
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ */
+mender_err_t delta_update_module_register(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DELTA_UPDATE_MODULE_H__ */
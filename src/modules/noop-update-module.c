@@ -51,7 +51,7 @@ noop_update_module_register(void) {
     if (MENDER_OK != (ret = mender_update_module_register(noop_update_module))) {
         mender_log_error("Unable to register the 'noop-update' update module");
         /* mender_update_module_register() takes ownership if it succeeds */
-        free(noop_update_module);
+        mender_free(noop_update_module);
         return ret;
     }
 
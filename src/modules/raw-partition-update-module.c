@@ -0,0 +1,424 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <mender/alloc.h>
+#include <mender/client.h>
+#include <mender/log.h>
+#include <mender/utils.h>
+#include <mender/update-module.h>
+
+#include "raw-partition-update-module.h"
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_HASH
+#include "utils/download-hash.h"
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_HASH */
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_RESUME
+#include "utils/download-resume.h"
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_RESUME */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+/* Writes the payload of a 'raw-partition' artifact as-is to a partition of the devicetree:
+ *
+ *   chosen {
+ *       mender,raw-partition = &raw_partition;
+ *   };
+ *
+ * Download blocks come in arbitrary sizes, they are collected in a buffer and only written to
+ * flash in full, write-block aligned chunks. Sector erase is done by a dedicated work queue which
+ * keeps CONFIG_MENDER_APP_RAW_PARTITION_ERASE_AHEAD sectors ahead of the write cursor, so that
+ * most of the erasing happens while the client is waiting for the network. The partition is
+ * expected to have sectors of uniform size.
+ *
+ * With CONFIG_MENDER_APP_DOWNLOAD_RESUME, the fully written sectors are committed as the download
+ * goes. A resumed download starts erasing and writing at the committed offset, the data before it
+ * is only read back for the client. */
+
+#if !DT_HAS_CHOSEN(mender_raw_partition)
+#error "The raw-partition Update Module needs a partition chosen as mender,raw-partition in the devicetree"
+#endif
+
+#define RAW_PARTITION_ID DT_FIXED_PARTITION_ID(DT_CHOSEN(mender_raw_partition))
+
+static mender_err_t raw_partition_update_module_download(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t raw_partition_update_module_install(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t raw_partition_update_module_commit(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t raw_partition_update_module_cleanup(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static mender_err_t raw_partition_update_module_failure(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static const struct flash_area *raw_partition_fa;
+static size_t                   raw_partition_sector_size;
+static size_t                   raw_partition_write_size;
+static size_t                   raw_partition_erase_end;
+static size_t                   raw_partition_written;
+static size_t                   raw_partition_resumed;
+static size_t                   raw_partition_buffered;
+static int64_t                  raw_partition_start_ms;
+static bool                     raw_partition_complete;
+
+static uint8_t raw_partition_buffer[CONFIG_MENDER_APP_RAW_PARTITION_WRITE_BUFFER_SIZE] __aligned(4);
+
+/* Shared with the erase work queue */
+static atomic_t raw_partition_erased_until;
+static atomic_t raw_partition_write_cursor;
+static atomic_t raw_partition_erase_ret;
+static atomic_t raw_partition_erase_cancel;
+static K_SEM_DEFINE(raw_partition_erase_sem, 0, 1);
+
+static struct k_work_q raw_partition_erase_q;
+static struct k_work   raw_partition_erase_work;
+static K_THREAD_STACK_DEFINE(raw_partition_erase_stack, CONFIG_MENDER_APP_RAW_PARTITION_ERASE_STACK_SIZE);
+
+static void
+raw_partition_erase_handler(struct k_work *work) {
+    ARG_UNUSED(work);
+
+    while (!atomic_get(&raw_partition_erase_cancel)) {
+        size_t erased = (size_t)atomic_get(&raw_partition_erased_until);
+        size_t limit  = (size_t)atomic_get(&raw_partition_write_cursor) + CONFIG_MENDER_APP_RAW_PARTITION_ERASE_AHEAD * raw_partition_sector_size;
+
+        limit = MIN(ROUND_UP(limit, raw_partition_sector_size), raw_partition_erase_end);
+        if (erased >= limit) {
+            break;
+        }
+
+        int rc = flash_area_erase(raw_partition_fa, erased, raw_partition_sector_size);
+        if (0 != rc) {
+            atomic_set(&raw_partition_erase_ret, rc);
+            k_sem_give(&raw_partition_erase_sem);
+            break;
+        }
+        atomic_set(&raw_partition_erased_until, erased + raw_partition_sector_size);
+        k_sem_give(&raw_partition_erase_sem);
+    }
+}
+
+static void
+raw_partition_erase_stop(void) {
+    atomic_set(&raw_partition_erase_cancel, 1);
+    k_work_cancel(&raw_partition_erase_work);
+    struct k_work_sync sync;
+    k_work_flush(&raw_partition_erase_work, &sync);
+}
+
+static void
+raw_partition_close(void) {
+    if (NULL != raw_partition_fa) {
+        raw_partition_erase_stop();
+        flash_area_close(raw_partition_fa);
+        raw_partition_fa = NULL;
+    }
+}
+
+static mender_err_t
+raw_partition_open(size_t size) {
+    int rc;
+
+    raw_partition_close();
+
+    if (0 != (rc = flash_area_open(RAW_PARTITION_ID, &raw_partition_fa))) {
+        mender_log_error("Unable to open the raw partition: %d", rc);
+        raw_partition_fa = NULL;
+        return MENDER_FAIL;
+    }
+    if (size > raw_partition_fa->fa_size) {
+        mender_log_error("Payload of %zu bytes does not fit into the raw partition (%zu bytes)", size, (size_t)raw_partition_fa->fa_size);
+        goto FAIL;
+    }
+
+    const struct device    *flash_dev = flash_area_get_device(raw_partition_fa);
+    struct flash_pages_info page_info;
+    if (0 != (rc = flash_get_page_info_by_offs(flash_dev, raw_partition_fa->fa_off, &page_info))) {
+        mender_log_error("Unable to get the sector size of the raw partition: %d", rc);
+        goto FAIL;
+    }
+    raw_partition_sector_size = page_info.size;
+    raw_partition_write_size  = flash_get_write_block_size(flash_dev);
+    if (0 != (sizeof(raw_partition_buffer) % raw_partition_write_size)) {
+        mender_log_error("Write buffer is not a multiple of the %zu bytes flash write block", raw_partition_write_size);
+        goto FAIL;
+    }
+
+    raw_partition_resumed = 0;
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_RESUME
+    /* Committed offsets are sector aligned */
+    raw_partition_resumed = download_resume_offset(size);
+    if (0 != (raw_partition_resumed % raw_partition_sector_size)) {
+        mender_log_error("Resume offset %zu is not sector aligned", raw_partition_resumed);
+        goto FAIL;
+    }
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_RESUME */
+
+    raw_partition_erase_end = MIN(ROUND_UP(size, raw_partition_sector_size), raw_partition_fa->fa_size);
+    raw_partition_written   = raw_partition_resumed;
+    raw_partition_buffered  = 0;
+    raw_partition_start_ms  = k_uptime_get();
+    raw_partition_complete  = false;
+
+    atomic_set(&raw_partition_erased_until, raw_partition_resumed);
+    atomic_set(&raw_partition_write_cursor, raw_partition_resumed);
+    atomic_set(&raw_partition_erase_ret, 0);
+    atomic_set(&raw_partition_erase_cancel, 0);
+    k_sem_reset(&raw_partition_erase_sem);
+
+    /* Start erasing right away, the first data is still on its way */
+    k_work_submit_to_queue(&raw_partition_erase_q, &raw_partition_erase_work);
+
+    return MENDER_OK;
+
+FAIL:
+    flash_area_close(raw_partition_fa);
+    raw_partition_fa = NULL;
+    return MENDER_FAIL;
+}
+
+static mender_err_t
+raw_partition_flush(void) {
+    if (0 == raw_partition_buffered) {
+        return MENDER_OK;
+    }
+
+    /* Pad the tail of the payload to the flash write block */
+    size_t length = ROUND_UP(raw_partition_buffered, raw_partition_write_size);
+    memset(raw_partition_buffer + raw_partition_buffered, flash_area_erased_val(raw_partition_fa), length - raw_partition_buffered);
+
+    /* Normally the sectors are already erased, otherwise wait for the erase work queue */
+    atomic_set(&raw_partition_write_cursor, raw_partition_written + length);
+    while ((size_t)atomic_get(&raw_partition_erased_until) < MIN(raw_partition_written + length, raw_partition_erase_end)) {
+        int rc = (int)atomic_get(&raw_partition_erase_ret);
+        if (0 != rc) {
+            mender_log_error("Unable to erase the raw partition: %d", rc);
+            return MENDER_FAIL;
+        }
+        k_work_submit_to_queue(&raw_partition_erase_q, &raw_partition_erase_work);
+        k_sem_take(&raw_partition_erase_sem, K_FOREVER);
+    }
+
+    int rc = flash_area_write(raw_partition_fa, raw_partition_written, raw_partition_buffer, length);
+    if (0 != rc) {
+        mender_log_error("Unable to write %zu bytes at offset %zu of the raw partition: %d", length, raw_partition_written, rc);
+        return MENDER_FAIL;
+    }
+
+    raw_partition_written += length;
+    raw_partition_buffered = 0;
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_RESUME
+    /* The last sector may still be erased again when resuming */
+    download_resume_commit(ROUND_DOWN(raw_partition_written, raw_partition_sector_size));
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_RESUME */
+
+    /* Let the erase work queue move ahead of the new cursor */
+    k_work_submit_to_queue(&raw_partition_erase_q, &raw_partition_erase_work);
+
+    return MENDER_OK;
+}
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_RESUME
+static int
+raw_partition_read(size_t offset, void *data, size_t length) {
+    const struct flash_area *fa;
+    int                      rc;
+
+    /* The partition is not open yet when the client is fed the committed data */
+    if (0 != (rc = flash_area_open(RAW_PARTITION_ID, &fa))) {
+        return rc;
+    }
+    rc = flash_area_read(fa, offset, data, length);
+    flash_area_close(fa);
+
+    return rc;
+}
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_RESUME */
+
+mender_err_t
+raw_partition_update_module_register(void) {
+    mender_err_t            ret;
+    mender_update_module_t *raw_partition_update_module;
+
+    k_work_init(&raw_partition_erase_work, raw_partition_erase_handler);
+    k_work_queue_start(&raw_partition_erase_q,
+                       raw_partition_erase_stack,
+                       K_THREAD_STACK_SIZEOF(raw_partition_erase_stack),
+                       CONFIG_MENDER_APP_RAW_PARTITION_ERASE_PRIORITY,
+                       NULL);
+    k_thread_name_set(&raw_partition_erase_q.thread, "raw_partition_erase");
+
+    /* Register the raw-partition update module */
+    if (NULL == (raw_partition_update_module = mender_calloc(1, sizeof(mender_update_module_t)))) {
+        mender_log_error("Unable to allocate memory for the 'raw-partition' update module");
+        return MENDER_FAIL;
+    }
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_DOWNLOAD]        = &raw_partition_update_module_download;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_INSTALL]         = &raw_partition_update_module_install;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_REBOOT]          = NULL;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_VERIFY_REBOOT]   = NULL;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_COMMIT]          = &raw_partition_update_module_commit;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_CLEANUP]         = &raw_partition_update_module_cleanup;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK]        = NULL;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_FAILURE]         = &raw_partition_update_module_failure;
+    raw_partition_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK_REBOOT] = NULL;
+    raw_partition_update_module->artifact_type                                  = "raw-partition";
+    raw_partition_update_module->requires_reboot                                = false;
+    raw_partition_update_module->supports_rollback                              = false;
+
+    if (MENDER_OK != (ret = mender_update_module_register(raw_partition_update_module))) {
+        mender_log_error("Unable to register the 'raw-partition' update module");
+        /* mender_update_module_register() takes ownership if it succeeds */
+        mender_free(raw_partition_update_module);
+        return ret;
+    }
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_RESUME
+    if (MENDER_OK != (ret = download_resume_init(raw_partition_read))) {
+        mender_log_error("Unable to resume the downloads of the 'raw-partition' update module");
+        return ret;
+    }
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_RESUME */
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+raw_partition_update_module_download(MENDER_NDEBUG_UNUSED mender_update_state_t state, mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_DOWNLOAD == state);
+
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+
+    if (NULL == dl_data->filename) {
+        return MENDER_OK;
+    }
+
+    if (0 == dl_data->offset) {
+        if (raw_partition_complete) {
+            mender_log_error("Only one payload file is supported by the 'raw-partition' update module");
+            return MENDER_FAIL;
+        }
+        if (MENDER_OK != raw_partition_open(dl_data->size)) {
+            return MENDER_FAIL;
+        }
+    }
+    if (NULL == raw_partition_fa) {
+        mender_log_error("Raw partition is not open");
+        return MENDER_FAIL;
+    }
+
+    /* Coalesce the block into the write buffer, flushing every time it is full */
+    const uint8_t *data   = dl_data->data;
+    size_t         length = dl_data->length;
+
+    /* Already in flash, the client is only catching up */
+    if (dl_data->offset < raw_partition_resumed) {
+        size_t skip = MIN(length, raw_partition_resumed - dl_data->offset);
+        data += skip;
+        length -= skip;
+    }
+    while (length > 0) {
+        size_t chunk = MIN(length, sizeof(raw_partition_buffer) - raw_partition_buffered);
+        memcpy(raw_partition_buffer + raw_partition_buffered, data, chunk);
+        raw_partition_buffered += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if ((sizeof(raw_partition_buffer) == raw_partition_buffered) && (MENDER_OK != raw_partition_flush())) {
+            return MENDER_FAIL;
+        }
+    }
+
+    if (dl_data->done) {
+        if (MENDER_OK != raw_partition_flush()) {
+            return MENDER_FAIL;
+        }
+        raw_partition_close();
+        raw_partition_complete = true;
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_RESUME
+        download_resume_done();
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_RESUME */
+
+        uint32_t elapsed_ms = MAX((uint32_t)(k_uptime_get() - raw_partition_start_ms), 1);
+        mender_log_info("raw-partition: wrote %zu bytes in %u ms (%llu B/s)",
+                        dl_data->size,
+                        elapsed_ms,
+                        (unsigned long long)dl_data->size * 1000 / elapsed_ms);
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+raw_partition_update_module_install(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_INSTALL == state);
+
+    /* The data is written in place during the download, nothing left to do */
+    if (!raw_partition_complete) {
+        mender_log_error("The raw partition has not been completely written");
+        return MENDER_FAIL;
+    }
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_HASH
+    /* Hashed while downloading, no need to read the partition back */
+    uint8_t digest[DOWNLOAD_HASH_SIZE];
+    char    digest_hex[2 * DOWNLOAD_HASH_SIZE + 1];
+    size_t  size;
+    if (MENDER_OK != download_hash_get(digest, &size)) {
+        mender_log_error("No checksum of the raw partition content");
+        return MENDER_FAIL;
+    }
+    bin2hex(digest, sizeof(digest), digest_hex, sizeof(digest_hex));
+    mender_log_info("raw-partition: %zu bytes, sha256 %s", size, digest_hex);
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_HASH */
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+raw_partition_update_module_commit(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_COMMIT == state);
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+raw_partition_update_module_cleanup(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_CLEANUP == state);
+
+    raw_partition_close();
+    raw_partition_complete = false;
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+raw_partition_update_module_failure(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_FAILURE == state);
+
+    /* The content of the partition is undefined after an interrupted download, apart from the
+     * sectors committed for resuming it */
+    raw_partition_close();
+    raw_partition_complete = false;
+
+    return MENDER_OK;
+}
@@ -0,0 +1,36 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __RAW_PARTITION_UPDATE_MODULE_H__
+#define __RAW_PARTITION_UPDATE_MODULE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <mender/utils.h>
+
+/**
+ * @brief Register the 'raw-partition' Update Module
+ * @note The payload is written as-is to the partition chosen as mender,raw-partition in the
+ *       devicetree
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ */
+mender_err_t raw_partition_update_module_register(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __RAW_PARTITION_UPDATE_MODULE_H__ */
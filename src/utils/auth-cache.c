@@ -0,0 +1,290 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The client authenticates on every boot and keeps the token in RAM only. The token of a
+ * successful authentication is saved here with its exp claim, along with a hash of the server and
+ * of the authentication request, which carries the identity, the public key and the tenant token.
+ *
+ * The first authentication request after a boot is answered from the saved token when the request
+ * hashes the same and, if the device has a wall clock, the token has not expired: it is not sent,
+ * and the client gets the token as if the server had returned it. Without a clock the expiry is
+ * left to the server. Any 401 drops the saved token, and the client authenticates again by itself
+ * on a 401, this time with the server. */
+
+#include "auth-cache.h"
+#include "http-observer.h"
+#include "persist.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/base64.h>
+#include <zephyr/sys/util.h>
+
+#define AUTH_CACHE_KEY         "auth/token"
+#define AUTH_CACHE_URL         "/api/devices/v1/authentication/auth_requests"
+#define AUTH_CACHE_CLAIMS_SIZE 512
+
+/* Expire a bit early, the token still has to be good for the first requests */
+#define AUTH_CACHE_EXPIRY_MARGIN_S 60
+/* Wall clocks before that have not been set */
+#define AUTH_CACHE_CLOCK_VALID 1700000000
+
+typedef struct {
+    uint32_t request_hash;
+    uint32_t len;
+    int64_t  expires; /* exp claim, 0 if the token has none */
+    char     token[CONFIG_MENDER_APP_AUTH_CACHE_TOKEN_SIZE];
+} auth_cache_entry_t;
+
+#define AUTH_CACHE_HEADER_SIZE offsetof(auth_cache_entry_t, token)
+
+static auth_cache_entry_t auth_cache_saved;
+static bool               auth_cache_valid;
+static bool               auth_cache_used;
+
+/* Authentication request being sent, only touched from the client thread */
+static auth_cache_entry_t auth_cache_received;
+static http_response_cb_t auth_cache_response;
+static bool               auth_cache_overflow;
+
+static char    auth_cache_b64[DIV_ROUND_UP(AUTH_CACHE_CLAIMS_SIZE, 3) * 4 + 1];
+static uint8_t auth_cache_claims[AUTH_CACHE_CLAIMS_SIZE + 1];
+
+static uint32_t
+auth_cache_fnv1a(uint32_t hash, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)s[i]) * 16777619U;
+    }
+    return hash;
+}
+
+static bool
+auth_cache_is_auth(const struct http_request *req) {
+    return (HTTP_POST == req->method) && (NULL != req->url) && (NULL != strstr(req->url, AUTH_CACHE_URL));
+}
+
+/* Hash of the server and of the signed request, 0 if the request has no payload to hash */
+static uint32_t
+auth_cache_request_hash(const struct http_request *req) {
+    uint32_t hash = 2166136261U;
+
+    if (NULL == req->payload) {
+        return 0;
+    }
+    if (NULL != req->host) {
+        hash = auth_cache_fnv1a(hash, req->host, strlen(req->host));
+    }
+    hash = auth_cache_fnv1a(hash, req->payload, req->payload_len);
+
+    return (0 == hash) ? 1 : hash;
+}
+
+/* Decodes the exp claim from the payload of the JWT */
+static int64_t
+auth_cache_claim_exp(const char *token, size_t len) {
+    const char *payload = memchr(token, '.', len);
+    if (NULL == payload) {
+        return 0;
+    }
+    payload++;
+    const char *end = memchr(payload, '.', len - (payload - token));
+    if (NULL == end) {
+        return 0;
+    }
+
+    /* base64url without padding to base64 */
+    size_t n = end - payload;
+    if (n + 3 >= sizeof(auth_cache_b64)) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        auth_cache_b64[i] = ('-' == payload[i]) ? '+' : ('_' == payload[i]) ? '/' : payload[i];
+    }
+    while (0 != (n % 4)) {
+        auth_cache_b64[n++] = '=';
+    }
+
+    size_t olen;
+    if (0 != base64_decode(auth_cache_claims, sizeof(auth_cache_claims) - 1, &olen, (const uint8_t *)auth_cache_b64, n)) {
+        return 0;
+    }
+    auth_cache_claims[olen] = '\0';
+
+    const char *exp = strstr((const char *)auth_cache_claims, "\"exp\":");
+    if (NULL == exp) {
+        return 0;
+    }
+    return strtoll(exp + strlen("\"exp\":"), NULL, 10);
+}
+
+static bool
+auth_cache_expired(int64_t expires) {
+#ifdef CONFIG_POSIX_TIMERS
+    struct timespec now;
+
+    if ((0 != expires) && (0 == clock_gettime(CLOCK_REALTIME, &now)) && (now.tv_sec > AUTH_CACHE_CLOCK_VALID)) {
+        return (now.tv_sec + AUTH_CACHE_EXPIRY_MARGIN_S) >= expires;
+    }
+#else
+    ARG_UNUSED(expires);
+#endif /* CONFIG_POSIX_TIMERS */
+
+    return false;
+}
+
+static void
+auth_cache_forget(void) {
+    if (auth_cache_valid) {
+        LOG_INF("Dropping the saved authentication token");
+        auth_cache_valid = false;
+        persist_delete(AUTH_CACHE_KEY);
+    }
+}
+
+static void
+auth_cache_save(void) {
+    /* Trailing white space is not part of the token */
+    while ((auth_cache_received.len > 0) && (auth_cache_received.token[auth_cache_received.len - 1] <= ' ')) {
+        auth_cache_received.len--;
+    }
+    if (0 == auth_cache_received.len) {
+        return;
+    }
+    auth_cache_received.expires = auth_cache_claim_exp(auth_cache_received.token, auth_cache_received.len);
+
+    if (0 != persist_save(AUTH_CACHE_KEY, &auth_cache_received, AUTH_CACHE_HEADER_SIZE + auth_cache_received.len)) {
+        LOG_WRN("Unable to save the authentication token");
+        return;
+    }
+    memcpy(&auth_cache_saved, &auth_cache_received, AUTH_CACHE_HEADER_SIZE + auth_cache_received.len);
+    auth_cache_valid = true;
+    LOG_INF("Saved the authentication token");
+}
+
+static int
+auth_cache_answer(struct http_request *req, void *user_data) {
+    if (!auth_cache_is_auth(req) || !auth_cache_valid || auth_cache_used) {
+        return -1;
+    }
+    /* Only on startup, later authentications follow a 401 */
+    auth_cache_used = true;
+
+    if ((auth_cache_request_hash(req) != auth_cache_saved.request_hash) || (auth_cache_saved.len > req->recv_buf_len)) {
+        LOG_INF("The saved authentication token is for another identity or server");
+        auth_cache_forget();
+        return -1;
+    }
+    if (auth_cache_expired(auth_cache_saved.expires)) {
+        LOG_INF("The saved authentication token has expired");
+        auth_cache_forget();
+        return -1;
+    }
+
+    /* Answer as the server would have */
+    struct http_response *rsp = &req->internal.response;
+    memset(rsp, 0, sizeof(*rsp));
+    memcpy(req->recv_buf, auth_cache_saved.token, auth_cache_saved.len);
+    rsp->recv_buf         = req->recv_buf;
+    rsp->recv_buf_len     = req->recv_buf_len;
+    rsp->data_len         = auth_cache_saved.len;
+    rsp->processed        = auth_cache_saved.len;
+    rsp->content_length   = auth_cache_saved.len;
+    rsp->body_frag_start  = req->recv_buf;
+    rsp->body_frag_len    = auth_cache_saved.len;
+    rsp->http_status_code = 200;
+    strncpy(rsp->http_status, "OK", sizeof(rsp->http_status) - 1);
+    rsp->cl_present       = 1;
+    rsp->body_found       = 1;
+    rsp->message_complete = 1;
+
+    if (req->response(rsp, HTTP_DATA_FINAL, user_data) < 0) {
+        LOG_WRN("The client did not take the saved authentication token");
+        return -1;
+    }
+    LOG_INF("Authenticated with the saved token");
+
+    return (int)auth_cache_saved.len;
+}
+
+static int
+auth_cache_response_cb(struct http_response *rsp, enum http_final_call final_data, void *user_data) {
+    if ((NULL != rsp->body_frag_start) && (rsp->body_frag_len > 0)) {
+        if (auth_cache_received.len + rsp->body_frag_len <= sizeof(auth_cache_received.token)) {
+            memcpy(&auth_cache_received.token[auth_cache_received.len], rsp->body_frag_start, rsp->body_frag_len);
+            auth_cache_received.len += rsp->body_frag_len;
+        } else {
+            auth_cache_overflow = true;
+        }
+    }
+
+    return auth_cache_response(rsp, final_data, user_data);
+}
+
+static void
+auth_cache_prepare(struct http_request *req) {
+    if (!auth_cache_is_auth(req)) {
+        return;
+    }
+
+    auth_cache_received.request_hash = auth_cache_request_hash(req);
+    auth_cache_received.len          = 0;
+    auth_cache_overflow              = false;
+
+    auth_cache_response = req->response;
+    req->response       = auth_cache_response_cb;
+}
+
+static void
+auth_cache_complete(struct http_request *req, int ret) {
+    bool ok = (ret >= 0) && (200 == req->internal.response.http_status_code);
+
+    if (auth_cache_response_cb == req->response) {
+        req->response = auth_cache_response;
+        if (ok && !auth_cache_overflow && (0 != auth_cache_received.request_hash)) {
+            auth_cache_save();
+        } else if (ok) {
+            LOG_WRN("The authentication token does not fit, it is not saved");
+        }
+    }
+
+    if ((ret >= 0) && (401 == req->internal.response.http_status_code)) {
+        auth_cache_forget();
+    }
+}
+
+static const http_observer_interceptor_t auth_cache_interceptor = {
+    .answer   = auth_cache_answer,
+    .prepare  = auth_cache_prepare,
+    .complete = auth_cache_complete,
+};
+
+mender_err_t
+auth_cache_init(void) {
+    int len = persist_load(AUTH_CACHE_KEY, &auth_cache_saved, sizeof(auth_cache_saved));
+
+    if ((len >= (int)AUTH_CACHE_HEADER_SIZE) && ((size_t)len == AUTH_CACHE_HEADER_SIZE + auth_cache_saved.len)) {
+        auth_cache_valid = true;
+        LOG_INF("Saved authentication token found");
+    } else if (-ENOENT != len) {
+        LOG_WRN("Unable to load the authentication token: %d", len);
+    }
+
+    return http_observer_intercept(&auth_cache_interceptor);
+}
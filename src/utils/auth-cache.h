@@ -0,0 +1,36 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __AUTH_CACHE_H__
+#define __AUTH_CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <mender/utils.h>
+
+/**
+ * @brief Load the saved authentication token and start answering the authentication requests of
+ *        the client with it
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note Must be called before the client is activated
+ */
+mender_err_t auth_cache_init(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __AUTH_CACHE_H__ */
@@ -22,10 +22,16 @@
 static const unsigned char primary_certificate[] = {
 #include "PrimaryCertificate.cer.inc"
 };
+/* With MENDER_APP_COMPACT_TRUST_ANCHORS, the certificates are reduced at build time to what the
+ * TLS layer uses of a trusted root, see scripts/trust-anchors.py */
 #ifdef CONFIG_MENDER_NET_CA_CERTIFICATE_TAG_SECONDARY_ENABLED
+#ifdef CERTS_SECONDARY_IS_PRIMARY
+#define secondary_certificate primary_certificate
+#else
 static const unsigned char secondary_certificate[] = {
 #include "SecondaryCertificate.cer.inc"
 };
+#endif /* CERTS_SECONDARY_IS_PRIMARY */
 #endif
 #endif
 
@@ -0,0 +1,275 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include "delta-patch.h"
+
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+enum {
+    DELTA_PATCH_STATE_HEADER = 0,
+    DELTA_PATCH_STATE_COPY_LEN,
+    DELTA_PATCH_STATE_INSERT_LEN,
+    DELTA_PATCH_STATE_SEEK,
+    DELTA_PATCH_STATE_SAME_LEN,
+    DELTA_PATCH_STATE_SAME,
+    DELTA_PATCH_STATE_CHANGED_LEN,
+    DELTA_PATCH_STATE_CHANGED,
+    DELTA_PATCH_STATE_INSERT,
+    DELTA_PATCH_STATE_DONE,
+};
+
+void
+delta_patch_init(delta_patch_t *patch, delta_patch_read_t read, delta_patch_write_t write, void *ctx) {
+    assert(NULL != patch);
+    assert(NULL != read);
+    assert(NULL != write);
+
+    memset(patch, 0, sizeof(*patch));
+    patch->read  = read;
+    patch->write = write;
+    patch->ctx   = ctx;
+    patch->state = DELTA_PATCH_STATE_HEADER;
+}
+
+static int
+delta_patch_parse_header(delta_patch_t *patch) {
+    const uint8_t *buf = patch->header_buf;
+
+    if ((0 != memcmp(buf, DELTA_PATCH_MAGIC, 4)) || (DELTA_PATCH_VERSION != buf[4])) {
+        return -EINVAL;
+    }
+    patch->header.source_size = sys_get_le32(&buf[8]);
+    patch->header.target_size = sys_get_le32(&buf[12]);
+    memcpy(patch->header.source_sha256, &buf[16], 32);
+    memcpy(patch->header.target_sha256, &buf[48], 32);
+
+    return 0;
+}
+
+static void
+delta_patch_end_record(delta_patch_t *patch) {
+    patch->state = (patch->produced == patch->header.target_size) ? DELTA_PATCH_STATE_DONE : DELTA_PATCH_STATE_COPY_LEN;
+}
+
+static int
+delta_patch_end_copy(delta_patch_t *patch) {
+    int64_t source_pos = (int64_t)patch->source_pos + patch->seek;
+    if ((source_pos < 0) || (source_pos > (int64_t)patch->header.source_size)) {
+        return -EINVAL;
+    }
+    patch->source_pos = (size_t)source_pos;
+
+    if (patch->insert_left > 0) {
+        patch->state = DELTA_PATCH_STATE_INSERT;
+    } else {
+        delta_patch_end_record(patch);
+    }
+    return 0;
+}
+
+/* Produce n target bytes from the source, adding delta to them when given */
+static int
+delta_patch_from_source(delta_patch_t *patch, const uint8_t *delta, size_t n) {
+    int rc;
+
+    if (patch->source_pos + n > patch->header.source_size) {
+        return -EINVAL;
+    }
+    if (0 != (rc = patch->read(patch->ctx, patch->source_pos, patch->source_buf, n))) {
+        return rc;
+    }
+    if (NULL != delta) {
+        for (size_t i = 0; i < n; i++) {
+            patch->source_buf[i] += delta[i];
+        }
+    }
+    if (0 != (rc = patch->write(patch->ctx, patch->source_buf, n))) {
+        return rc;
+    }
+    patch->source_pos += n;
+    patch->produced += n;
+    return 0;
+}
+
+/* Returns 1 when the varint is complete, 0 when more bytes are needed */
+static int
+delta_patch_varint(delta_patch_t *patch, uint8_t byte, uint64_t *value) {
+    if (patch->varint_shift > 63) {
+        return -EINVAL;
+    }
+    patch->varint |= (uint64_t)(byte & 0x7f) << patch->varint_shift;
+    patch->varint_shift += 7;
+    if (0 != (byte & 0x80)) {
+        return 0;
+    }
+    *value               = patch->varint;
+    patch->varint        = 0;
+    patch->varint_shift  = 0;
+    return 1;
+}
+
+int
+delta_patch_process(delta_patch_t *patch, const uint8_t *data, size_t len) {
+    assert(NULL != patch);
+    assert((NULL != data) || (0 == len));
+
+    int      rc;
+    uint64_t value;
+
+    for (;;) {
+        /* Runs of unchanged source bytes do not consume any input */
+        if (DELTA_PATCH_STATE_SAME == patch->state) {
+            while (patch->run_left > 0) {
+                size_t n = MIN(patch->run_left, sizeof(patch->source_buf));
+                if (0 != (rc = delta_patch_from_source(patch, NULL, n))) {
+                    return rc;
+                }
+                patch->run_left -= n;
+            }
+            patch->state = DELTA_PATCH_STATE_CHANGED_LEN;
+        }
+
+        if (0 == len) {
+            return 0;
+        }
+
+        switch (patch->state) {
+            case DELTA_PATCH_STATE_HEADER: {
+                size_t n = MIN(len, DELTA_PATCH_HEADER_SIZE - patch->header_len);
+                memcpy(patch->header_buf + patch->header_len, data, n);
+                patch->header_len += n;
+                data += n;
+                len -= n;
+                if (DELTA_PATCH_HEADER_SIZE == patch->header_len) {
+                    if (0 != (rc = delta_patch_parse_header(patch))) {
+                        return rc;
+                    }
+                    delta_patch_end_record(patch);
+                }
+                break;
+            }
+
+            case DELTA_PATCH_STATE_COPY_LEN:
+            case DELTA_PATCH_STATE_INSERT_LEN:
+            case DELTA_PATCH_STATE_SEEK:
+            case DELTA_PATCH_STATE_SAME_LEN:
+            case DELTA_PATCH_STATE_CHANGED_LEN:
+                rc = delta_patch_varint(patch, *data, &value);
+                data++;
+                len--;
+                if (rc < 0) {
+                    return rc;
+                } else if (0 == rc) {
+                    break;
+                }
+
+                /* Lengths are checked against what is left of the target before they are narrowed to
+                   size_t, which would wrap the bigger ones on 32-bit targets */
+                if (DELTA_PATCH_STATE_COPY_LEN == patch->state) {
+                    if (value > patch->header.target_size - patch->produced) {
+                        return -EINVAL;
+                    }
+                    patch->copy_left = (size_t)value;
+                    patch->state     = DELTA_PATCH_STATE_INSERT_LEN;
+                } else if (DELTA_PATCH_STATE_INSERT_LEN == patch->state) {
+                    if (value > patch->header.target_size - patch->produced - patch->copy_left) {
+                        return -EINVAL;
+                    }
+                    patch->insert_left = (size_t)value;
+                    patch->state       = DELTA_PATCH_STATE_SEEK;
+                } else if (DELTA_PATCH_STATE_SEEK == patch->state) {
+                    /* zigzag */
+                    patch->seek = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+                    if (patch->copy_left > 0) {
+                        patch->state = DELTA_PATCH_STATE_SAME_LEN;
+                    } else if (0 != (rc = delta_patch_end_copy(patch))) {
+                        return rc;
+                    }
+                } else {
+                    if (value > patch->copy_left) {
+                        return -EINVAL;
+                    }
+                    patch->run_left = (size_t)value;
+                    patch->copy_left -= (size_t)value;
+                    if (DELTA_PATCH_STATE_SAME_LEN == patch->state) {
+                        patch->state = DELTA_PATCH_STATE_SAME;
+                    } else if (patch->run_left > 0) {
+                        patch->state = DELTA_PATCH_STATE_CHANGED;
+                    } else if (patch->copy_left > 0) {
+                        patch->state = DELTA_PATCH_STATE_SAME_LEN;
+                    } else if (0 != (rc = delta_patch_end_copy(patch))) {
+                        return rc;
+                    }
+                }
+                break;
+
+            case DELTA_PATCH_STATE_CHANGED: {
+                size_t n = MIN(MIN(patch->run_left, len), sizeof(patch->source_buf));
+                if (0 != (rc = delta_patch_from_source(patch, data, n))) {
+                    return rc;
+                }
+                data += n;
+                len -= n;
+                patch->run_left -= n;
+                if (patch->run_left > 0) {
+                    break;
+                }
+                if (patch->copy_left > 0) {
+                    patch->state = DELTA_PATCH_STATE_SAME_LEN;
+                } else if (0 != (rc = delta_patch_end_copy(patch))) {
+                    return rc;
+                }
+                break;
+            }
+
+            case DELTA_PATCH_STATE_INSERT: {
+                size_t n = MIN(patch->insert_left, len);
+                if (0 != (rc = patch->write(patch->ctx, data, n))) {
+                    return rc;
+                }
+                data += n;
+                len -= n;
+                patch->insert_left -= n;
+                patch->produced += n;
+                if (0 == patch->insert_left) {
+                    delta_patch_end_record(patch);
+                }
+                break;
+            }
+
+            default:
+                /* Trailing data after the target is complete */
+                return -EINVAL;
+        }
+    }
+}
+
+const delta_patch_header_t *
+delta_patch_get_header(const delta_patch_t *patch) {
+    assert(NULL != patch);
+
+    return (DELTA_PATCH_STATE_HEADER == patch->state) ? NULL : &patch->header;
+}
+
+bool
+delta_patch_is_done(const delta_patch_t *patch) {
+    assert(NULL != patch);
+
+    return DELTA_PATCH_STATE_DONE == patch->state;
+}
@@ -0,0 +1,130 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DELTA_PATCH_H__
+#define __DELTA_PATCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Streaming decoder for the binary patches produced by scripts/delta-patch.py.
+ *
+ * The format follows bsdiff: the target is rebuilt from runs of source bytes "plus a small
+ * difference", literal bytes, and seeks in the source. All integers are little endian, varints
+ * are LEB128 and signed varints are zigzag encoded.
+ *
+ *   header:
+ *     char     magic[4]            "MDLT"
+ *     uint8_t  version             1
+ *     uint8_t  reserved[3]
+ *     uint32_t source_size
+ *     uint32_t target_size
+ *     uint8_t  source_sha256[32]
+ *     uint8_t  target_sha256[32]
+ *   records, until target_size bytes are produced:
+ *     varint   copy_len            target bytes derived from the source at the current position
+ *     varint   insert_len          literal target bytes following the copy
+ *     svarint  seek                added to the source position after the copy
+ *     copy data, until copy_len bytes are covered:
+ *       varint same                bytes equal to the source
+ *       varint changed             followed by changed bytes of (target - source) mod 256
+ *     insert data:
+ *       insert_len bytes
+ *
+ * The decoder is fed with arbitrary sized blocks and only keeps a small source read buffer. */
+
+#define DELTA_PATCH_MAGIC   "MDLT"
+#define DELTA_PATCH_VERSION 1
+
+#define DELTA_PATCH_HEADER_SIZE 80
+
+#ifndef DELTA_PATCH_SOURCE_BUFFER_SIZE
+#define DELTA_PATCH_SOURCE_BUFFER_SIZE 256
+#endif
+
+/**
+ * @brief Read len bytes of the source at offset into buf
+ * @return 0 on success, -errno on error
+ */
+typedef int (*delta_patch_read_t)(void *ctx, size_t offset, uint8_t *buf, size_t len);
+
+/**
+ * @brief Append len bytes to the target
+ * @return 0 on success, -errno on error
+ */
+typedef int (*delta_patch_write_t)(void *ctx, const uint8_t *buf, size_t len);
+
+typedef struct {
+    uint32_t source_size;
+    uint32_t target_size;
+    uint8_t  source_sha256[32];
+    uint8_t  target_sha256[32];
+} delta_patch_header_t;
+
+typedef struct {
+    delta_patch_read_t  read;
+    delta_patch_write_t write;
+    void               *ctx;
+
+    int                  state;
+    delta_patch_header_t header;
+    uint8_t              header_buf[DELTA_PATCH_HEADER_SIZE];
+    size_t               header_len;
+
+    uint64_t varint;
+    unsigned varint_shift;
+
+    size_t  copy_left;
+    size_t  insert_left;
+    size_t  run_left;
+    int64_t seek;
+
+    size_t source_pos;
+    size_t produced;
+
+    uint8_t source_buf[DELTA_PATCH_SOURCE_BUFFER_SIZE];
+} delta_patch_t;
+
+/**
+ * @brief Prepare a decoder
+ */
+void delta_patch_init(delta_patch_t *patch, delta_patch_read_t read, delta_patch_write_t write, void *ctx);
+
+/**
+ * @brief Feed the next block of the patch
+ * @return 0 on success, -EINVAL on a malformed patch, or the error of the read/write callbacks
+ */
+int delta_patch_process(delta_patch_t *patch, const uint8_t *data, size_t len);
+
+/**
+ * @brief Get the header once it has been received
+ * @return NULL if the header is not complete yet
+ */
+const delta_patch_header_t *delta_patch_get_header(const delta_patch_t *patch);
+
+/**
+ * @brief Check whether the whole target has been produced
+ */
+bool delta_patch_is_done(const delta_patch_t *patch);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DELTA_PATCH_H__ */
@@ -0,0 +1,401 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Log backend capturing the lines logged during a deployment into a RAM ring. Lines are formatted
+ * as the deployment logs of the client expect them, and front coded: a record only holds what
+ * differs from the previous line, after the length of the prefix they share (timestamp, level,
+ * module). When the ring is full the oldest records are dropped; the full text of the oldest one
+ * is kept aside, as the records after it cannot be decoded without it.
+ *
+ *   record := prefix (1 byte) | length (1 byte) | suffix (length bytes)
+ *
+ * Capturing is a copy into the ring, from the thread of the deferred logging, which the end of the
+ * deployment waits for to process the lines already logged. Nothing is written to flash unless
+ * the deployment fails: the lines are then stored as the logs of the deployment, replacing the
+ * ones the client kept, and the client uploads them with the failure status.
+ *
+ * The client may publish the failure, with the logs, before it calls the deployment status
+ * callback, so the lines are stored from the Update Modules instead: as soon as one of their
+ * callbacks fails, or when the client enters their failure or rollback state for a failure of its
+ * own. Like the download stages, each wrapped Update Module gets a trampoline of its own. */
+
+#include "deploy-log.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/logging/log_output.h>
+
+#include <mender/storage.h>
+#include <mender/update-module.h>
+
+#define DEPLOY_LOG_LINE_SIZE 255
+#define DEPLOY_LOG_FLAGS     (LOG_OUTPUT_FLAG_LEVEL | LOG_OUTPUT_FLAG_TIMESTAMP | LOG_OUTPUT_FLAG_FORMAT_TIMESTAMP)
+
+/* Longest wait for the messages logged before the end of the deployment to be processed */
+#define DEPLOY_LOG_DRAIN_TIMEOUT_MS 1000
+
+#define DEPLOY_LOG_MAX_MODULES   CONFIG_MENDER_APP_UPDATE_MODULES_MAX
+#define DEPLOY_LOG_UPDATE_STATES ARRAY_SIZE(((mender_update_module_t *)NULL)->callbacks)
+
+static uint8_t deploy_log_ring[CONFIG_MENDER_APP_DEPLOY_LOG_RING_SIZE];
+static size_t  deploy_log_head; /* Oldest record */
+static size_t  deploy_log_used;
+
+/* Last line written, to front code the next one */
+static char    deploy_log_prev[DEPLOY_LOG_LINE_SIZE];
+static uint8_t deploy_log_prev_len;
+
+/* Full text of the oldest record */
+static char    deploy_log_base[DEPLOY_LOG_LINE_SIZE];
+static uint8_t deploy_log_base_len;
+
+/* Counters of the last captured deployment, logged at its end */
+typedef struct {
+    uint32_t lines;   /* Lines captured */
+    uint32_t dropped; /* Oldest lines dropped from the full ring, or lost by the logging */
+    uint32_t raw;     /* Bytes of the captured lines */
+    uint32_t stored;  /* Bytes the kept lines take in the ring */
+} deploy_log_stats_t;
+
+static deploy_log_stats_t deploy_log_stats;
+
+static struct k_spinlock deploy_log_lock;
+static atomic_t          deploy_log_active = ATOMIC_INIT(0);
+
+/* Line being formatted, only touched by the logging thread */
+static char   deploy_log_line[DEPLOY_LOG_LINE_SIZE];
+static size_t deploy_log_line_len;
+
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG_QUIET
+/* Backends deactivated for the deployment */
+static uint32_t deploy_log_muted;
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG_QUIET */
+
+static int
+deploy_log_out(uint8_t *data, size_t length, void *ctx) {
+    ARG_UNUSED(ctx);
+
+    /* Longer lines are truncated */
+    size_t len = MIN(length, sizeof(deploy_log_line) - deploy_log_line_len);
+    memcpy(&deploy_log_line[deploy_log_line_len], data, len);
+    deploy_log_line_len += len;
+
+    return (int)length;
+}
+
+static uint8_t deploy_log_output_buf[64];
+LOG_OUTPUT_DEFINE(deploy_log_output, deploy_log_out, deploy_log_output_buf, sizeof(deploy_log_output_buf));
+
+static void
+deploy_log_ring_read(size_t offset, void *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        ((uint8_t *)data)[i] = deploy_log_ring[(offset + i) % sizeof(deploy_log_ring)];
+    }
+}
+
+static void
+deploy_log_ring_write(size_t offset, const void *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        deploy_log_ring[(offset + i) % sizeof(deploy_log_ring)] = ((const uint8_t *)data)[i];
+    }
+}
+
+/* Drops the oldest record, must be called with the lock held */
+static void
+deploy_log_drop(void) {
+    uint8_t header[2];
+
+    deploy_log_ring_read(deploy_log_head, header, sizeof(header));
+    deploy_log_head = (deploy_log_head + sizeof(header) + header[1]) % sizeof(deploy_log_ring);
+    deploy_log_used -= sizeof(header) + header[1];
+    deploy_log_stats.stored -= sizeof(header) + header[1];
+    deploy_log_stats.dropped++;
+
+    if (0 == deploy_log_used) {
+        return;
+    }
+
+    /* The next record becomes the oldest one, decode it against the dropped one */
+    deploy_log_ring_read(deploy_log_head, header, sizeof(header));
+    deploy_log_ring_read(deploy_log_head + sizeof(header), &deploy_log_base[header[0]], header[1]);
+    deploy_log_base_len = header[0] + header[1];
+}
+
+/* Appends the formatted line, must be called with the lock held */
+static void
+deploy_log_commit(const char *line, uint8_t len) {
+    uint8_t prefix = 0;
+
+    while ((prefix < len) && (prefix < deploy_log_prev_len) && (line[prefix] == deploy_log_prev[prefix])) {
+        prefix++;
+    }
+
+    uint8_t header[2] = { prefix, len - prefix };
+    size_t  size      = sizeof(header) + header[1];
+
+    if (size > sizeof(deploy_log_ring)) {
+        deploy_log_stats.dropped++;
+        return;
+    }
+    while (deploy_log_used + size > sizeof(deploy_log_ring)) {
+        deploy_log_drop();
+    }
+    if (0 == deploy_log_used) {
+        memcpy(deploy_log_base, line, len);
+        deploy_log_base_len = len;
+    }
+
+    size_t tail = (deploy_log_head + deploy_log_used) % sizeof(deploy_log_ring);
+    deploy_log_ring_write(tail, header, sizeof(header));
+    deploy_log_ring_write(tail + sizeof(header), &line[prefix], header[1]);
+    deploy_log_used += size;
+
+    memcpy(deploy_log_prev, line, len);
+    deploy_log_prev_len = len;
+
+    deploy_log_stats.lines++;
+    deploy_log_stats.raw += len;
+    deploy_log_stats.stored += size;
+}
+
+static void
+deploy_log_process(const struct log_backend *const backend, union log_msg_generic *msg) {
+    ARG_UNUSED(backend);
+
+    if (!atomic_get(&deploy_log_active)) {
+        return;
+    }
+
+    deploy_log_line_len = 0;
+    log_output_msg_process(&deploy_log_output, &msg->log, DEPLOY_LOG_FLAGS);
+    while ((deploy_log_line_len > 0)
+           && (('\r' == deploy_log_line[deploy_log_line_len - 1]) || ('\n' == deploy_log_line[deploy_log_line_len - 1]))) {
+        deploy_log_line_len--;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&deploy_log_lock);
+    /* Checked again, the deployment may have ended while formatting */
+    if (atomic_get(&deploy_log_active) && (deploy_log_line_len > 0)) {
+        deploy_log_commit(deploy_log_line, (uint8_t)deploy_log_line_len);
+    }
+    k_spin_unlock(&deploy_log_lock, key);
+}
+
+static void
+deploy_log_dropped(const struct log_backend *const backend, uint32_t cnt) {
+    ARG_UNUSED(backend);
+
+    if (atomic_get(&deploy_log_active)) {
+        k_spinlock_key_t key = k_spin_lock(&deploy_log_lock);
+        deploy_log_stats.dropped += cnt;
+        k_spin_unlock(&deploy_log_lock, key);
+    }
+}
+
+static void
+deploy_log_panic(const struct log_backend *const backend) {
+    ARG_UNUSED(backend);
+
+    atomic_clear(&deploy_log_active);
+}
+
+static const struct log_backend_api deploy_log_api = {
+    .process = deploy_log_process,
+    .dropped = deploy_log_dropped,
+    .panic   = deploy_log_panic,
+};
+
+LOG_BACKEND_DEFINE(deploy_log_backend, deploy_log_api, true);
+
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG_QUIET
+static void
+deploy_log_mute(bool mute) {
+    for (int i = 0; (i < log_backend_count_get()) && (i < 32); i++) {
+        const struct log_backend *backend = log_backend_get(i);
+
+        if (&deploy_log_backend == backend) {
+            continue;
+        }
+        if (mute && log_backend_is_active(backend)) {
+            log_backend_deactivate(backend);
+            deploy_log_muted |= BIT(i);
+        } else if (!mute && (deploy_log_muted & BIT(i))) {
+            log_backend_activate(backend, backend->cb->ctx);
+        }
+    }
+    if (!mute) {
+        deploy_log_muted = 0;
+    }
+}
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG_QUIET */
+
+/* Stores the captured lines as the logs of the deployment */
+static void
+deploy_log_store(void) {
+    char    line[DEPLOY_LOG_LINE_SIZE];
+    uint8_t header[2];
+    size_t  offset = deploy_log_head;
+    size_t  left   = deploy_log_used;
+
+    if (MENDER_OK != mender_storage_deployment_log_clear()) {
+        LOG_WRN("Unable to clear the deployment logs");
+        return;
+    }
+
+    /* The first record is decoded from the base */
+    memcpy(line, deploy_log_base, deploy_log_base_len);
+    uint8_t len = deploy_log_base_len;
+
+    while (left > 0) {
+        deploy_log_ring_read(offset, header, sizeof(header));
+        if (offset != deploy_log_head) {
+            deploy_log_ring_read(offset + sizeof(header), &line[header[0]], header[1]);
+            len = header[0] + header[1];
+        }
+        offset = (offset + sizeof(header) + header[1]) % sizeof(deploy_log_ring);
+        left -= sizeof(header) + header[1];
+
+        if (MENDER_OK != mender_storage_deployment_log_append(line, len)) {
+            LOG_WRN("Unable to store the deployment logs");
+            return;
+        }
+    }
+}
+
+void
+deploy_log_begin(void) {
+    k_spinlock_key_t key = k_spin_lock(&deploy_log_lock);
+    deploy_log_head     = 0;
+    deploy_log_used     = 0;
+    deploy_log_prev_len = 0;
+    deploy_log_base_len = 0;
+    memset(&deploy_log_stats, 0, sizeof(deploy_log_stats));
+    atomic_set(&deploy_log_active, 1);
+    k_spin_unlock(&deploy_log_lock, key);
+
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG_QUIET
+    deploy_log_mute(true);
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG_QUIET */
+}
+
+/* Waits for the deferred logging to process the messages already queued, the last lines of the
+   deployment; other threads may keep logging, hence the timeout */
+static void
+deploy_log_drain(void) {
+    int64_t deadline = k_uptime_get() + DEPLOY_LOG_DRAIN_TIMEOUT_MS;
+
+    while (log_data_pending() && (k_uptime_get() < deadline)) {
+#ifdef CONFIG_LOG_PROCESS_THREAD
+        log_thread_trigger();
+        k_msleep(1);
+#else
+        log_process();
+#endif /* CONFIG_LOG_PROCESS_THREAD */
+    }
+}
+
+void
+deploy_log_end(bool failed) {
+    if (!atomic_get(&deploy_log_active)) {
+        return;
+    }
+    deploy_log_drain();
+    if (!atomic_cas(&deploy_log_active, 1, 0)) {
+        return;
+    }
+
+    /* Lines being formatted are not committed after this */
+    k_spinlock_key_t key = k_spin_lock(&deploy_log_lock);
+    k_spin_unlock(&deploy_log_lock, key);
+
+#ifdef CONFIG_MENDER_APP_DEPLOY_LOG_QUIET
+    deploy_log_mute(false);
+#endif /* CONFIG_MENDER_APP_DEPLOY_LOG_QUIET */
+
+    LOG_INF("Deployment log: %u lines, %u bytes stored in %u, %u dropped",
+            deploy_log_stats.lines,
+            deploy_log_stats.raw,
+            deploy_log_stats.stored,
+            deploy_log_stats.dropped);
+
+    if (failed) {
+        deploy_log_store();
+    }
+}
+
+typedef mender_err_t (*deploy_log_cb_t)(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static deploy_log_cb_t deploy_log_next[DEPLOY_LOG_MAX_MODULES][DEPLOY_LOG_UPDATE_STATES];
+static size_t          deploy_log_count;
+
+static mender_err_t
+deploy_log_update_state(size_t module, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    /* The client failed by itself, e.g. to download; deploy_log_end() only stores once */
+    if ((MENDER_UPDATE_STATE_FAILURE == state) || (MENDER_UPDATE_STATE_ROLLBACK == state)) {
+        deploy_log_end(true);
+    }
+
+    mender_err_t ret = deploy_log_next[module][state](state, callback_data);
+    if (ret < MENDER_OK) {
+        deploy_log_end(true);
+    }
+
+    return ret;
+}
+
+#define DEPLOY_LOG_TRAMPOLINE(_i, _)                                                                                \
+    static mender_err_t deploy_log_update_state_##_i(mender_update_state_t state, mender_update_state_data_t data) { \
+        return deploy_log_update_state(_i, state, data);                                                            \
+    }
+#define DEPLOY_LOG_TRAMPOLINE_NAME(_i, _) deploy_log_update_state_##_i
+
+LISTIFY(DEPLOY_LOG_MAX_MODULES, DEPLOY_LOG_TRAMPOLINE, ())
+
+static const deploy_log_cb_t deploy_log_trampolines[DEPLOY_LOG_MAX_MODULES]
+    = { LISTIFY(DEPLOY_LOG_MAX_MODULES, DEPLOY_LOG_TRAMPOLINE_NAME, (, )) };
+
+mender_err_t
+deploy_log_wrap(const char *artifact_type) {
+    assert(NULL != artifact_type);
+
+    mender_update_module_t *update_module = mender_update_module_get(artifact_type);
+    if (NULL == update_module) {
+        LOG_ERR("No Update Module registered for '%s'", artifact_type);
+        return MENDER_FAIL;
+    }
+    if (deploy_log_count >= DEPLOY_LOG_MAX_MODULES) {
+        LOG_ERR("Cannot capture the logs of more than %d Update Modules", DEPLOY_LOG_MAX_MODULES);
+        return MENDER_FAIL;
+    }
+
+    size_t i = deploy_log_count++;
+    for (size_t state = 0; state < DEPLOY_LOG_UPDATE_STATES; state++) {
+        /* The client skips the states without a callback, they stay so */
+        deploy_log_next[i][state] = update_module->callbacks[state];
+        if (NULL != update_module->callbacks[state]) {
+            update_module->callbacks[state] = deploy_log_trampolines[i];
+        }
+    }
+
+    return MENDER_OK;
+}
@@ -0,0 +1,50 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DEPLOY_LOG_H__
+#define __DEPLOY_LOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Start capturing the log lines of a deployment, dropping the previous ones
+ */
+void deploy_log_begin(void);
+
+/**
+ * @brief Stop capturing
+ * @param failed Store the captured lines as the logs of the deployment, for the client to upload
+ */
+void deploy_log_end(bool failed);
+
+/**
+ * @brief Store the captured lines as soon as a callback of a registered Update Module fails
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL if the module is unknown or too many are wrapped
+ * @note The client may publish the failure, with the logs, before calling the deployment status
+ *       callback, which is then too late to store them
+ */
+mender_err_t deploy_log_wrap(const char *artifact_type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DEPLOY_LOG_H__ */
@@ -0,0 +1,305 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Streaming heatshrink decoder. The bit stream is MSB first; a 1 tag bit is followed by an 8 bit
+ * literal, a 0 tag bit by a window_sz2 bit index and a lookahead_sz2 bit count, both stored minus
+ * one, copying count bytes from index bytes back in the window. The only memory used is the
+ * window and the output buffer, both static and sized by Kconfig, whatever the payload size. */
+
+#include "download-decompress.h"
+#include "download-stage.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#define DECOMPRESS_WINDOW_SZ2_MAX CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS_WINDOW_SZ2
+#define DECOMPRESS_OUTPUT_SIZE    CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS_OUTPUT_BUFFER_SIZE
+#define DECOMPRESS_HEADER_SIZE    8
+#define DECOMPRESS_FILENAME_MAX   64
+
+enum {
+    DECOMPRESS_STATE_PASSTHROUGH = 0,
+    DECOMPRESS_STATE_HEADER,
+    DECOMPRESS_STATE_TAG,
+    DECOMPRESS_STATE_LITERAL,
+    DECOMPRESS_STATE_INDEX,
+    DECOMPRESS_STATE_COUNT,
+    DECOMPRESS_STATE_DONE,
+};
+
+static int     decompress_state;
+static uint8_t decompress_header[DECOMPRESS_HEADER_SIZE];
+static size_t  decompress_header_len;
+static uint8_t decompress_window_sz2;
+static uint8_t decompress_lookahead_sz2;
+static size_t  decompress_size;
+
+static uint32_t decompress_bits;
+static uint8_t  decompress_bit_count;
+static uint16_t decompress_index;
+
+static uint8_t decompress_window[1 << DECOMPRESS_WINDOW_SZ2_MAX];
+static size_t  decompress_window_pos;
+
+static uint8_t decompress_output[DECOMPRESS_OUTPUT_SIZE];
+static size_t  decompress_output_len;
+static size_t  decompress_produced;
+static size_t  decompress_consumed;
+
+/* Name of the payload without the suffix, as seen by the Update Module */
+static char decompress_filename[DECOMPRESS_FILENAME_MAX];
+
+static mender_err_t download_decompress_download(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data);
+static void         download_decompress_reset(void);
+
+static const download_stage_ops_t download_decompress_ops = {
+    .name     = "decompress",
+    .download = download_decompress_download,
+    .reset    = download_decompress_reset,
+};
+
+DOWNLOAD_STAGE_DEFINE(download_decompress_stage, &download_decompress_ops);
+
+static bool
+download_decompress_is_compressed(const char *filename) {
+    size_t len        = strlen(filename);
+    size_t suffix_len = strlen(DOWNLOAD_DECOMPRESS_SUFFIX);
+
+    return (len > suffix_len) && (0 == strcmp(filename + len - suffix_len, DOWNLOAD_DECOMPRESS_SUFFIX));
+}
+
+static mender_err_t
+download_decompress_flush(download_stage_cb_t next, const struct mender_update_download_state_data_s *dl_data, bool done) {
+    struct mender_update_download_state_data_s out_data      = *dl_data;
+    mender_update_state_data_t                 callback_data = { .download_state_data = &out_data };
+
+    out_data.filename = decompress_filename;
+    out_data.size     = decompress_size;
+    out_data.data     = decompress_output;
+    out_data.offset   = decompress_produced - decompress_output_len;
+    out_data.length   = decompress_output_len;
+    out_data.done     = done;
+
+    decompress_output_len = 0;
+
+    return next(MENDER_UPDATE_STATE_DOWNLOAD, callback_data);
+}
+
+static mender_err_t
+download_decompress_emit(download_stage_cb_t next, const struct mender_update_download_state_data_s *dl_data, uint8_t byte) {
+    mender_err_t ret;
+
+    /* Flush lazily, so that the last block always carries the done flag */
+    if ((sizeof(decompress_output) == decompress_output_len) && (MENDER_OK != (ret = download_decompress_flush(next, dl_data, false)))) {
+        return ret;
+    }
+
+    decompress_output[decompress_output_len++]                                       = byte;
+    decompress_window[decompress_window_pos++ & ((1U << decompress_window_sz2) - 1)] = byte;
+    decompress_produced++;
+
+    if (decompress_produced == decompress_size) {
+        decompress_state = DECOMPRESS_STATE_DONE;
+    }
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+download_decompress_parse_header(void) {
+    if ((0 != memcmp(decompress_header, "HS", 2))) {
+        LOG_ERR("Not a heatshrink compressed payload");
+        return MENDER_FAIL;
+    }
+    decompress_window_sz2    = decompress_header[2];
+    decompress_lookahead_sz2 = decompress_header[3];
+    decompress_size          = sys_get_le32(&decompress_header[4]);
+
+    if ((decompress_window_sz2 < 4) || (decompress_window_sz2 > DECOMPRESS_WINDOW_SZ2_MAX) || (decompress_lookahead_sz2 < 3)
+        || (decompress_lookahead_sz2 >= decompress_window_sz2)) {
+        LOG_ERR("Unsupported heatshrink parameters -w %u -l %u (window up to %u)",
+                decompress_window_sz2,
+                decompress_lookahead_sz2,
+                DECOMPRESS_WINDOW_SZ2_MAX);
+        return MENDER_FAIL;
+    }
+
+    memset(decompress_window, 0, sizeof(decompress_window));
+    decompress_window_pos = 0;
+    decompress_state      = (0 == decompress_size) ? DECOMPRESS_STATE_DONE : DECOMPRESS_STATE_TAG;
+
+    return MENDER_OK;
+}
+
+/* Returns true with the next n bits in value, false if the input ran out */
+static bool
+download_decompress_get_bits(const uint8_t **data, size_t *len, uint8_t n, uint16_t *value) {
+    while (decompress_bit_count < n) {
+        if (0 == *len) {
+            return false;
+        }
+        decompress_bits = (decompress_bits << 8) | *(*data)++;
+        decompress_bit_count += 8;
+        (*len)--;
+    }
+    decompress_bit_count -= n;
+    *value = (decompress_bits >> decompress_bit_count) & ((1U << n) - 1);
+
+    return true;
+}
+
+static mender_err_t
+download_decompress_process(download_stage_cb_t next, const struct mender_update_download_state_data_s *dl_data) {
+    const uint8_t *data = dl_data->data;
+    size_t         len  = dl_data->length;
+    uint16_t       value;
+    mender_err_t   ret;
+
+    for (;;) {
+        switch (decompress_state) {
+            case DECOMPRESS_STATE_HEADER: {
+                size_t n = MIN(len, DECOMPRESS_HEADER_SIZE - decompress_header_len);
+                memcpy(decompress_header + decompress_header_len, data, n);
+                decompress_header_len += n;
+                data += n;
+                len -= n;
+                if (DECOMPRESS_HEADER_SIZE > decompress_header_len) {
+                    return MENDER_OK;
+                }
+                if (MENDER_OK != (ret = download_decompress_parse_header())) {
+                    return ret;
+                }
+                break;
+            }
+
+            case DECOMPRESS_STATE_TAG:
+                if (!download_decompress_get_bits(&data, &len, 1, &value)) {
+                    return MENDER_OK;
+                }
+                decompress_state = value ? DECOMPRESS_STATE_LITERAL : DECOMPRESS_STATE_INDEX;
+                break;
+
+            case DECOMPRESS_STATE_LITERAL:
+                if (!download_decompress_get_bits(&data, &len, 8, &value)) {
+                    return MENDER_OK;
+                }
+                decompress_state = DECOMPRESS_STATE_TAG;
+                if (MENDER_OK != (ret = download_decompress_emit(next, dl_data, (uint8_t)value))) {
+                    return ret;
+                }
+                break;
+
+            case DECOMPRESS_STATE_INDEX:
+                if (!download_decompress_get_bits(&data, &len, decompress_window_sz2, &decompress_index)) {
+                    return MENDER_OK;
+                }
+                decompress_index++;
+                decompress_state = DECOMPRESS_STATE_COUNT;
+                break;
+
+            case DECOMPRESS_STATE_COUNT: {
+                if (!download_decompress_get_bits(&data, &len, decompress_lookahead_sz2, &value)) {
+                    return MENDER_OK;
+                }
+                decompress_state = DECOMPRESS_STATE_TAG;
+                for (size_t count = (size_t)value + 1; (count > 0) && (DECOMPRESS_STATE_DONE != decompress_state); count--) {
+                    uint8_t byte = decompress_window[(decompress_window_pos - decompress_index) & ((1U << decompress_window_sz2) - 1)];
+                    if (MENDER_OK != (ret = download_decompress_emit(next, dl_data, byte))) {
+                        return ret;
+                    }
+                }
+                break;
+            }
+
+            default:
+                /* Only the padding bits of the last byte are expected after the end */
+                if (len > 0) {
+                    LOG_ERR("Trailing data after the end of the compressed payload");
+                    return MENDER_FAIL;
+                }
+                return MENDER_OK;
+        }
+    }
+}
+
+static mender_err_t
+download_decompress_download(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_DOWNLOAD == state);
+    assert(NULL != next);
+
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+    mender_err_t                                ret;
+
+    if (NULL == dl_data->filename) {
+        return next(state, callback_data);
+    }
+
+    if (0 == dl_data->offset) {
+        download_decompress_reset();
+        if (download_decompress_is_compressed(dl_data->filename)) {
+            size_t len = strlen(dl_data->filename) - strlen(DOWNLOAD_DECOMPRESS_SUFFIX);
+            if (len >= sizeof(decompress_filename)) {
+                LOG_ERR("Payload name '%s' is too long", dl_data->filename);
+                return MENDER_FAIL;
+            }
+            memcpy(decompress_filename, dl_data->filename, len);
+            decompress_filename[len] = '\0';
+            decompress_state         = DECOMPRESS_STATE_HEADER;
+        }
+    }
+
+    if (DECOMPRESS_STATE_PASSTHROUGH == decompress_state) {
+        return next(state, callback_data);
+    }
+
+    if (MENDER_OK != (ret = download_decompress_process(next, dl_data))) {
+        return ret;
+    }
+    decompress_consumed += dl_data->length;
+
+    if (dl_data->done) {
+        if (DECOMPRESS_STATE_DONE != decompress_state) {
+            LOG_ERR("Compressed payload ended after %zu of %zu bytes", decompress_produced, decompress_size);
+            return MENDER_FAIL;
+        }
+        LOG_INF("Decompressed '%s': %zu bytes from %zu bytes", decompress_filename, decompress_produced, decompress_consumed);
+        ret = download_decompress_flush(next, dl_data, true);
+        download_decompress_reset();
+        return ret;
+    }
+
+    return MENDER_OK;
+}
+
+static void
+download_decompress_reset(void) {
+    decompress_state      = DECOMPRESS_STATE_PASSTHROUGH;
+    decompress_header_len = 0;
+    decompress_bits       = 0;
+    decompress_bit_count  = 0;
+    decompress_output_len = 0;
+    decompress_produced   = 0;
+    decompress_consumed   = 0;
+}
+
+mender_err_t
+download_decompress_wrap(const char *artifact_type) {
+    return download_stage_wrap(&download_decompress_stage, artifact_type);
+}
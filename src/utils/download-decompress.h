@@ -0,0 +1,49 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DOWNLOAD_DECOMPRESS_H__
+#define __DOWNLOAD_DECOMPRESS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <mender/utils.h>
+
+/* Payload files named "<name>.hs" are heatshrink (LZSS) compressed and prefixed with a small
+ * header, all integers are little endian:
+ *
+ *   char     magic[2]          "HS"
+ *   uint8_t  window_sz2        log2 of the window size
+ *   uint8_t  lookahead_sz2     log2 of the longest back-reference
+ *   uint32_t size              size of the decompressed payload
+ *
+ * The Update Module sees "<name>" and the decompressed data, with offset and size relative to it.
+ * See heatshrink_compress() in tests/integration/helpers.py for a compressor. */
+
+#define DOWNLOAD_DECOMPRESS_SUFFIX ".hs"
+
+/**
+ * @brief Decompress the heatshrink compressed payloads of a registered Update Module
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note Other payload files are passed through untouched
+ */
+mender_err_t download_decompress_wrap(const char *artifact_type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DOWNLOAD_DECOMPRESS_H__ */
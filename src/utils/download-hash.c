@@ -0,0 +1,119 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Feeds every block passed to the Update Module into a SHA-256 context before forwarding it, so
+ * that the digest is ready the moment the last block is written. Only one payload is downloaded
+ * at a time, a single context is enough. */
+
+#include "download-hash.h"
+#include "download-stage.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <mbedtls/sha256.h>
+
+static mbedtls_sha256_context hash_ctx;
+static bool                   hash_running;
+static size_t                 hash_size;
+
+/* Result of the last completed payload */
+static bool    hash_valid;
+static uint8_t hash_digest[DOWNLOAD_HASH_SIZE];
+
+static mender_err_t download_hash_download(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data);
+static void         download_hash_reset(void);
+
+static const download_stage_ops_t download_hash_ops = {
+    .name     = "hash",
+    .download = download_hash_download,
+    .reset    = download_hash_reset,
+};
+
+DOWNLOAD_STAGE_DEFINE(download_hash_stage, &download_hash_ops);
+
+static mender_err_t
+download_hash_download(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_DOWNLOAD == state);
+    assert(NULL != next);
+
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+
+    if (NULL == dl_data->filename) {
+        return next(state, callback_data);
+    }
+
+    if (0 == dl_data->offset) {
+        download_hash_reset();
+        mbedtls_sha256_init(&hash_ctx);
+        mbedtls_sha256_starts(&hash_ctx, 0);
+        hash_running = true;
+        hash_size    = 0;
+    }
+    if (!hash_running) {
+        LOG_ERR("Download of '%s' did not start at offset 0", dl_data->filename);
+        return MENDER_FAIL;
+    }
+
+    /* Blocks are hashed in order, any gap or overlap would make the digest meaningless */
+    if (dl_data->offset != hash_size) {
+        LOG_ERR("Unexpected block at offset %zu, expected %zu", dl_data->offset, hash_size);
+        return MENDER_FAIL;
+    }
+    mbedtls_sha256_update(&hash_ctx, dl_data->data, dl_data->length);
+    hash_size += dl_data->length;
+
+    mender_err_t ret = next(state, callback_data);
+
+    if ((MENDER_OK == ret) && dl_data->done) {
+        mbedtls_sha256_finish(&hash_ctx, hash_digest);
+        mbedtls_sha256_free(&hash_ctx);
+        hash_running = false;
+        hash_valid   = true;
+    }
+
+    return ret;
+}
+
+static void
+download_hash_reset(void) {
+    if (hash_running) {
+        mbedtls_sha256_free(&hash_ctx);
+        hash_running = false;
+    }
+    hash_valid = false;
+}
+
+mender_err_t
+download_hash_wrap(const char *artifact_type) {
+    return download_stage_wrap(&download_hash_stage, artifact_type);
+}
+
+mender_err_t
+download_hash_get(uint8_t digest[DOWNLOAD_HASH_SIZE], size_t *size) {
+    assert(NULL != digest);
+
+    if (!hash_valid) {
+        return MENDER_FAIL;
+    }
+    memcpy(digest, hash_digest, DOWNLOAD_HASH_SIZE);
+    if (NULL != size) {
+        *size = hash_size;
+    }
+
+    return MENDER_OK;
+}
@@ -0,0 +1,51 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DOWNLOAD_HASH_H__
+#define __DOWNLOAD_HASH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+#define DOWNLOAD_HASH_SIZE 32
+
+/**
+ * @brief Compute the SHA-256 of the payloads passed to a registered Update Module while they are downloaded
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note The digest covers the data as seen by the Update Module, i.e. after decompression
+ */
+mender_err_t download_hash_wrap(const char *artifact_type);
+
+/**
+ * @brief Get the SHA-256 of the last completely downloaded payload
+ * @param digest Digest of the payload
+ * @param size Size of the payload, may be NULL
+ * @return MENDER_OK on success, MENDER_FAIL if no download has completed since the last cleanup
+ *         or failure
+ * @note Meant for the INSTALL state, to verify a payload without reading it back from flash
+ */
+mender_err_t download_hash_get(uint8_t digest[DOWNLOAD_HASH_SIZE], size_t *size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DOWNLOAD_HASH_H__ */
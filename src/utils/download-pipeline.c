@@ -0,0 +1,259 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The client thread (producer) copies every downloaded block into a single-producer,
+ * single-consumer ring and returns immediately unless the ring is full. The writer thread
+ * (consumer) hands the blocks to the wrapped Update Module. Each index is only ever written by
+ * its owner; the two counting semaphores carry the occupancy and provide the memory ordering, so
+ * the ring itself needs no lock. A block without a next callback is a flush marker: once the
+ * writer reaches it, everything queued before has been written. */
+
+#include "download-pipeline.h"
+#include "download-stage.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#define PIPELINE_BLOCK_SIZE  CONFIG_MENDER_APP_DOWNLOAD_PIPELINE_BLOCK_SIZE
+#define PIPELINE_BLOCK_COUNT CONFIG_MENDER_APP_DOWNLOAD_PIPELINE_BLOCK_COUNT
+#define PIPELINE_BLOCK_MASK  (PIPELINE_BLOCK_COUNT - 1)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(PIPELINE_BLOCK_COUNT), "CONFIG_MENDER_APP_DOWNLOAD_PIPELINE_BLOCK_COUNT must be a power of two");
+
+#define PIPELINE_FILENAME_MAX 64
+
+/* Throughput counters of the last (or ongoing) payload download, logged at its end */
+typedef struct {
+    uint64_t bytes_received;   /* Bytes accepted from the Mender client */
+    uint64_t bytes_written;    /* Bytes handed over to the Update Module */
+    uint32_t elapsed_ms;       /* Time since the first block of the payload */
+    uint32_t client_stall_ms;  /* Time the client thread waited for a free block (backpressure) */
+    uint32_t module_busy_ms;   /* Time spent inside the Update Module download callback */
+    uint32_t peak_blocks;      /* Highest number of blocks queued at once */
+} download_pipeline_stats_t;
+
+typedef struct {
+    download_stage_cb_t                        next;
+    struct mender_update_download_state_data_s state_data;
+    uint8_t                                    data[PIPELINE_BLOCK_SIZE];
+} pipeline_block_t;
+
+static pipeline_block_t pipeline_ring[PIPELINE_BLOCK_COUNT];
+static uint32_t         pipeline_head; /* owned by the client thread */
+static uint32_t         pipeline_tail; /* owned by the writer thread */
+
+static K_SEM_DEFINE(pipeline_filled_sem, 0, PIPELINE_BLOCK_COUNT);
+static K_SEM_DEFINE(pipeline_free_sem, PIPELINE_BLOCK_COUNT, PIPELINE_BLOCK_COUNT);
+static K_SEM_DEFINE(pipeline_drained_sem, 0, 1);
+
+/* First error returned by the Update Module; sticky until the next payload or reset */
+static atomic_t pipeline_module_ret = ATOMIC_INIT(MENDER_OK);
+/* Set while dropping the blocks of an interrupted download */
+static atomic_t pipeline_discard = ATOMIC_INIT(0);
+
+/* The filename pointer of the client is only valid during its download */
+static char pipeline_filename[PIPELINE_FILENAME_MAX];
+
+static download_pipeline_stats_t pipeline_stats;
+static int64_t                   pipeline_start_ms;
+static uint64_t                  pipeline_busy_cycles;
+
+static mender_err_t download_pipeline_download(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data);
+static void         download_pipeline_reset(void);
+
+static const download_stage_ops_t download_pipeline_ops = {
+    .name     = "pipeline",
+    .download = download_pipeline_download,
+    .reset    = download_pipeline_reset,
+};
+
+DOWNLOAD_STAGE_DEFINE(download_pipeline_stage, &download_pipeline_ops);
+
+static void
+download_pipeline_writer(void *p1, void *p2, void *p3) {
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    for (;;) {
+        k_sem_take(&pipeline_filled_sem, K_FOREVER);
+        pipeline_block_t *block = &pipeline_ring[pipeline_tail & PIPELINE_BLOCK_MASK];
+
+        if (NULL == block->next) {
+            k_sem_give(&pipeline_drained_sem);
+        } else if ((MENDER_OK == atomic_get(&pipeline_module_ret)) && !atomic_get(&pipeline_discard)) {
+            mender_update_state_data_t callback_data = { .download_state_data = &block->state_data };
+
+            uint32_t     start = k_cycle_get_32();
+            mender_err_t ret   = block->next(MENDER_UPDATE_STATE_DOWNLOAD, callback_data);
+            pipeline_busy_cycles += k_cycle_get_32() - start;
+
+            if (MENDER_OK != ret) {
+                LOG_ERR("Update Module failed to write %zu bytes at offset %zu", block->state_data.length, block->state_data.offset);
+                atomic_set(&pipeline_module_ret, ret);
+            } else {
+                pipeline_stats.bytes_written += block->state_data.length;
+            }
+        }
+
+        pipeline_tail++;
+        k_sem_give(&pipeline_free_sem);
+    }
+}
+
+K_THREAD_DEFINE(download_pipeline_tid,
+                CONFIG_MENDER_APP_DOWNLOAD_PIPELINE_STACK_SIZE,
+                download_pipeline_writer,
+                NULL,
+                NULL,
+                NULL,
+                CONFIG_MENDER_APP_DOWNLOAD_PIPELINE_PRIORITY,
+                0,
+                0);
+
+static pipeline_block_t *
+download_pipeline_claim(void) {
+    if (0 != k_sem_take(&pipeline_free_sem, K_NO_WAIT)) {
+        /* Ring is full: this is the backpressure that slows down the socket */
+        int64_t start = k_uptime_get();
+        k_sem_take(&pipeline_free_sem, K_FOREVER);
+        pipeline_stats.client_stall_ms += (uint32_t)(k_uptime_get() - start);
+    }
+    return &pipeline_ring[pipeline_head & PIPELINE_BLOCK_MASK];
+}
+
+static void
+download_pipeline_publish(void) {
+    pipeline_head++;
+    k_sem_give(&pipeline_filled_sem);
+
+    uint32_t queued = k_sem_count_get(&pipeline_filled_sem);
+    if (queued > pipeline_stats.peak_blocks) {
+        pipeline_stats.peak_blocks = queued;
+    }
+}
+
+static mender_err_t
+download_pipeline_flush(void) {
+    pipeline_block_t *block = download_pipeline_claim();
+    block->next             = NULL;
+    download_pipeline_publish();
+
+    k_sem_take(&pipeline_drained_sem, K_FOREVER);
+
+    return (mender_err_t)atomic_get(&pipeline_module_ret);
+}
+
+static void
+download_pipeline_log_stats(void) {
+    pipeline_stats.elapsed_ms     = (uint32_t)(k_uptime_get() - pipeline_start_ms);
+    pipeline_stats.module_busy_ms = (uint32_t)k_cyc_to_ms_floor64(pipeline_busy_cycles);
+
+    uint32_t elapsed_ms = MAX(pipeline_stats.elapsed_ms, 1);
+    LOG_INF("Download pipeline: %llu bytes in %u ms (%llu B/s), client stalled %u ms, module busy %u ms, peak %u/%u blocks",
+            (unsigned long long)pipeline_stats.bytes_written,
+            pipeline_stats.elapsed_ms,
+            (unsigned long long)(pipeline_stats.bytes_written * 1000 / elapsed_ms),
+            pipeline_stats.client_stall_ms,
+            pipeline_stats.module_busy_ms,
+            pipeline_stats.peak_blocks,
+            PIPELINE_BLOCK_COUNT);
+}
+
+static mender_err_t
+download_pipeline_download(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    assert(MENDER_UPDATE_STATE_DOWNLOAD == state);
+    assert(NULL != next);
+
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+    mender_err_t                                ret;
+
+    /* Nothing to stream, keep the ordering with what is already queued and call through */
+    if (NULL == dl_data->filename) {
+        if (MENDER_OK != (ret = download_pipeline_flush())) {
+            return ret;
+        }
+        return next(state, callback_data);
+    }
+
+    if (0 == dl_data->offset) {
+        /* New payload: the previous one must be fully written before its filename is replaced */
+        if (MENDER_OK != (ret = download_pipeline_flush())) {
+            return ret;
+        }
+        /* Truncated, the name would not be the one the stages after this one check */
+        if (strlen(dl_data->filename) >= sizeof(pipeline_filename)) {
+            LOG_ERR("Payload name '%s' is too long", dl_data->filename);
+            return MENDER_FAIL;
+        }
+        strcpy(pipeline_filename, dl_data->filename);
+        memset(&pipeline_stats, 0, sizeof(pipeline_stats));
+        pipeline_busy_cycles = 0;
+        pipeline_start_ms    = k_uptime_get();
+    }
+
+    /* Fail fast, there is no point in downloading more if the module cannot take it */
+    if (MENDER_OK != (ret = (mender_err_t)atomic_get(&pipeline_module_ret))) {
+        return ret;
+    }
+
+    size_t consumed = 0;
+    do {
+        size_t            chunk = MIN(dl_data->length - consumed, PIPELINE_BLOCK_SIZE);
+        pipeline_block_t *block = download_pipeline_claim();
+
+        block->next                  = next;
+        block->state_data            = *dl_data;
+        block->state_data.filename   = pipeline_filename;
+        block->state_data.data       = block->data;
+        block->state_data.offset     = dl_data->offset + consumed;
+        block->state_data.length     = chunk;
+        block->state_data.done       = dl_data->done && (consumed + chunk == dl_data->length);
+        memcpy(block->data, (const uint8_t *)dl_data->data + consumed, chunk);
+
+        download_pipeline_publish();
+        pipeline_stats.bytes_received += chunk;
+        consumed += chunk;
+    } while (consumed < dl_data->length);
+
+    if (dl_data->done) {
+        ret = download_pipeline_flush();
+        download_pipeline_log_stats();
+        return ret;
+    }
+
+    return MENDER_OK;
+}
+
+static void
+download_pipeline_reset(void) {
+    /* Called from the client thread before CLEANUP and FAILURE: drop whatever is still queued
+       from an interrupted download and forget the error for the next deployment */
+    atomic_set(&pipeline_discard, 1);
+    download_pipeline_flush();
+    atomic_set(&pipeline_discard, 0);
+    atomic_set(&pipeline_module_ret, MENDER_OK);
+}
+
+mender_err_t
+download_pipeline_wrap(const char *artifact_type) {
+    return download_stage_wrap(&download_pipeline_stage, artifact_type);
+}
@@ -0,0 +1,41 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DOWNLOAD_PIPELINE_H__
+#define __DOWNLOAD_PIPELINE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Move the download callback of a registered Update Module to a dedicated writer thread
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note Blocks received by the client are copied into a fixed ring of
+ *       CONFIG_MENDER_APP_DOWNLOAD_PIPELINE_BLOCK_COUNT blocks and the client only waits when the
+ *       ring is full. Errors from the Update Module are reported on the next block and at the end
+ *       of the payload, when the ring is drained.
+ */
+mender_err_t download_pipeline_wrap(const char *artifact_type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DOWNLOAD_PIPELINE_H__ */
@@ -0,0 +1,424 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The client parses the artifact as one stream and checks the payload against the manifest, so it
+ * has to see every byte of it again when a download is resumed. While an artifact is downloaded,
+ * its tar headers are followed up to the payload; everything before the payload (version,
+ * manifest, header.tar and the headers of data/0000.tar) is saved in the settings, then the
+ * offset the Update Module reports as durably written, every few sectors.
+ *
+ * When the client requests the same artifact again (same host and path, the query of pre-signed
+ * links changes), the request gets a Range header starting after the committed data. If the
+ * server answers 206, the client is first fed the saved prefix and the committed payload, read
+ * back from the Update Module, as if the server had sent them, then the rest of the response.
+ * The status is reported as 200. If the server ignores the range, the download starts over.
+ *
+ * A dropped connection fails the deployment; the resume happens on its next attempt, after a
+ * retry of the deployment by the server or a reboot in the middle of the download. */
+
+#include "download-resume.h"
+#include "http-observer.h"
+#include "persist.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS
+#include "download-decompress.h"
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS */
+
+#define DOWNLOAD_RESUME_STATE_KEY  "resume/state"
+#define DOWNLOAD_RESUME_PREFIX_KEY "resume/prefix/%u"
+#define DOWNLOAD_RESUME_CHUNK_SIZE 1024
+#define DOWNLOAD_RESUME_API_PATH   "/api/devices/"
+#define DOWNLOAD_RESUME_HEADERS    8
+
+#define TAR_BLOCK_SIZE      512
+#define TAR_SIZE_OFFSET     124
+#define TAR_SIZE_LEN        12
+#define TAR_TYPEFLAG_OFFSET 156
+#define TAR_NAME_LEN        100
+
+typedef struct {
+    uint32_t url_hash;
+    uint32_t payload_start; /* Offset of the payload in the artifact, size of the saved prefix */
+    uint32_t payload_size;
+    uint32_t committed; /* Payload bytes durably written by the Update Module */
+} download_resume_state_t;
+
+static download_resume_read_cb_t download_resume_read;
+
+static download_resume_state_t download_resume_saved;
+static bool                    download_resume_saved_valid;
+
+/* Commits are only recorded for the download the saved state describes */
+static bool download_resume_armed;
+static bool download_resume_resuming;
+
+static K_MUTEX_DEFINE(download_resume_lock);
+
+/* Request being intercepted, only touched from the client thread */
+static http_response_cb_t download_resume_response;
+static const char       **download_resume_fields;
+static uint32_t           download_resume_hash;
+static bool               download_resume_ranged;
+static bool               download_resume_started;
+static bool               download_resume_tracking;
+static size_t             download_resume_received;
+static size_t             download_resume_next_header;
+static bool               download_resume_in_data;
+
+static const char *download_resume_headers[DOWNLOAD_RESUME_HEADERS + 2];
+static char        download_resume_range[40];
+
+static uint8_t download_resume_prefix[CONFIG_MENDER_APP_DOWNLOAD_RESUME_PREFIX_SIZE];
+static uint8_t download_resume_buf[DOWNLOAD_RESUME_CHUNK_SIZE];
+
+static uint32_t
+download_resume_fnv1a(uint32_t hash, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)s[i]) * 16777619U;
+    }
+    return hash;
+}
+
+static void
+download_resume_prefix_key(char *buf, size_t size, size_t index) {
+    snprintf(buf, size, DOWNLOAD_RESUME_PREFIX_KEY, (unsigned int)index);
+}
+
+/* Forgets the saved download, must be called with the lock held */
+static void
+download_resume_clear(void) {
+    char key[24];
+
+    download_resume_armed    = false;
+    download_resume_resuming = false;
+    if (!download_resume_saved_valid) {
+        return;
+    }
+
+    /* The state first, the prefix is useless without it */
+    persist_delete(DOWNLOAD_RESUME_STATE_KEY);
+    for (size_t i = 0; i < DIV_ROUND_UP(download_resume_saved.payload_start, DOWNLOAD_RESUME_CHUNK_SIZE); i++) {
+        download_resume_prefix_key(key, sizeof(key), i);
+        persist_delete(key);
+    }
+    download_resume_saved_valid = false;
+}
+
+/* Saves the prefix of a new download, must be called with the lock held */
+static void
+download_resume_arm(size_t payload_start, size_t payload_size) {
+    char key[24];
+
+    download_resume_clear();
+
+    for (size_t i = 0; i < DIV_ROUND_UP(payload_start, DOWNLOAD_RESUME_CHUNK_SIZE); i++) {
+        size_t offset = i * DOWNLOAD_RESUME_CHUNK_SIZE;
+        download_resume_prefix_key(key, sizeof(key), i);
+        if (0 != persist_save(key, &download_resume_prefix[offset], MIN(DOWNLOAD_RESUME_CHUNK_SIZE, payload_start - offset))) {
+            LOG_WRN("Unable to save the artifact header, the download will not be resumed");
+            return;
+        }
+    }
+
+    download_resume_saved.url_hash      = download_resume_hash;
+    download_resume_saved.payload_start = (uint32_t)payload_start;
+    download_resume_saved.payload_size  = (uint32_t)payload_size;
+    download_resume_saved.committed     = 0;
+    if (0 != persist_save(DOWNLOAD_RESUME_STATE_KEY, &download_resume_saved, sizeof(download_resume_saved))) {
+        LOG_WRN("Unable to save the download state, the download will not be resumed");
+        return;
+    }
+    download_resume_saved_valid = true;
+    download_resume_armed       = true;
+}
+
+static size_t
+download_resume_octal(const uint8_t *field, size_t len) {
+    size_t value = 0;
+
+    for (size_t i = 0; (i < len) && (field[i] >= '0') && (field[i] <= '7'); i++) {
+        value = (value << 3) | (field[i] - '0');
+    }
+    return value;
+}
+
+static bool
+download_resume_is_as_is(const char *name) {
+#ifdef CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS
+    /* The Update Module gets the decompressed data, which cannot be fed back to the client */
+    size_t len        = strnlen(name, TAR_NAME_LEN);
+    size_t suffix_len = strlen(DOWNLOAD_DECOMPRESS_SUFFIX);
+
+    return !((len > suffix_len) && (0 == strncmp(name + len - suffix_len, DOWNLOAD_DECOMPRESS_SUFFIX, suffix_len)));
+#else
+    ARG_UNUSED(name);
+    return true;
+#endif /* CONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS */
+}
+
+/* Follows the tar headers of a new download up to the payload */
+static void
+download_resume_track(const uint8_t *data, size_t len) {
+    if (download_resume_received < sizeof(download_resume_prefix)) {
+        memcpy(&download_resume_prefix[download_resume_received], data, MIN(len, sizeof(download_resume_prefix) - download_resume_received));
+    }
+    download_resume_received += len;
+
+    while (download_resume_tracking) {
+        if (download_resume_next_header + TAR_BLOCK_SIZE > sizeof(download_resume_prefix)) {
+            LOG_WRN("Artifact header larger than %d bytes, the download will not be resumed", CONFIG_MENDER_APP_DOWNLOAD_RESUME_PREFIX_SIZE);
+            download_resume_tracking = false;
+            break;
+        }
+        if (download_resume_next_header + TAR_BLOCK_SIZE > download_resume_received) {
+            break;
+        }
+
+        const uint8_t *header = &download_resume_prefix[download_resume_next_header];
+        size_t         size   = download_resume_octal(&header[TAR_SIZE_OFFSET], TAR_SIZE_LEN);
+        uint8_t        type   = header[TAR_TYPEFLAG_OFFSET];
+
+        if ('\0' == header[0]) {
+            /* End of the archive, no payload */
+            download_resume_tracking = false;
+        } else if (!download_resume_in_data) {
+            /* The payloads are in data/0000.tar, a tar in the tar */
+            if (0 == strncmp((const char *)header, "data/", strlen("data/"))) {
+                download_resume_in_data = true;
+                download_resume_next_header += TAR_BLOCK_SIZE;
+            } else {
+                download_resume_next_header += TAR_BLOCK_SIZE + ROUND_UP(size, TAR_BLOCK_SIZE);
+            }
+        } else if (('0' == type) || ('\0' == type)) {
+            download_resume_tracking = false;
+            if (download_resume_is_as_is((const char *)header)) {
+                k_mutex_lock(&download_resume_lock, K_FOREVER);
+                download_resume_arm(download_resume_next_header + TAR_BLOCK_SIZE, size);
+                k_mutex_unlock(&download_resume_lock);
+            }
+        } else {
+            /* Extended headers of the payload */
+            download_resume_next_header += TAR_BLOCK_SIZE + ROUND_UP(size, TAR_BLOCK_SIZE);
+        }
+    }
+}
+
+static int
+download_resume_feed(struct http_response *rsp, void *user_data, size_t len) {
+    rsp->body_frag_start = download_resume_buf;
+    rsp->body_frag_len   = len;
+
+    return download_resume_response(rsp, HTTP_DATA_MORE, user_data);
+}
+
+/* Feeds the client what it got before the interruption */
+static int
+download_resume_replay(struct http_response *rsp, void *user_data) {
+    uint8_t *frag_start = rsp->body_frag_start;
+    size_t   frag_len   = rsp->body_frag_len;
+    char     key[24];
+    int      ret = 0;
+
+    rsp->http_status_code = 200;
+    rsp->body_found       = 1;
+    if (rsp->cl_present) {
+        rsp->content_length += download_resume_saved.payload_start + download_resume_saved.committed;
+    }
+
+    for (size_t offset = 0; (ret >= 0) && (offset < download_resume_saved.payload_start); offset += DOWNLOAD_RESUME_CHUNK_SIZE) {
+        size_t len = MIN(DOWNLOAD_RESUME_CHUNK_SIZE, download_resume_saved.payload_start - offset);
+        download_resume_prefix_key(key, sizeof(key), offset / DOWNLOAD_RESUME_CHUNK_SIZE);
+        if ((int)len != persist_load(key, download_resume_buf, len)) {
+            LOG_ERR("Unable to load the artifact header");
+            ret = -EIO;
+            break;
+        }
+        ret = download_resume_feed(rsp, user_data, len);
+    }
+    for (size_t offset = 0; (ret >= 0) && (offset < download_resume_saved.committed); offset += DOWNLOAD_RESUME_CHUNK_SIZE) {
+        size_t len = MIN(DOWNLOAD_RESUME_CHUNK_SIZE, download_resume_saved.committed - offset);
+        if (0 != download_resume_read(offset, download_resume_buf, len)) {
+            LOG_ERR("Unable to read back the payload at offset %zu", offset);
+            ret = -EIO;
+            break;
+        }
+        ret = download_resume_feed(rsp, user_data, len);
+    }
+
+    rsp->body_frag_start = frag_start;
+    rsp->body_frag_len   = frag_len;
+
+    return ret;
+}
+
+static int
+download_resume_response_cb(struct http_response *rsp, enum http_final_call final_data, void *user_data) {
+    if (!download_resume_started) {
+        download_resume_started = true;
+
+        if (download_resume_ranged && (206 == rsp->http_status_code)) {
+            LOG_INF("Resuming the download at byte %u of the payload", download_resume_saved.committed);
+            k_mutex_lock(&download_resume_lock, K_FOREVER);
+            download_resume_armed    = true;
+            download_resume_resuming = true;
+            k_mutex_unlock(&download_resume_lock);
+
+            int ret = download_resume_replay(rsp, user_data);
+            if (ret < 0) {
+                /* Start over on the next attempt */
+                k_mutex_lock(&download_resume_lock, K_FOREVER);
+                download_resume_clear();
+                k_mutex_unlock(&download_resume_lock);
+                return ret;
+            }
+        } else if (200 == rsp->http_status_code) {
+            if (download_resume_ranged) {
+                LOG_WRN("The server does not support ranges, downloading from the start");
+            }
+            download_resume_tracking = true;
+        }
+    }
+
+    if (download_resume_tracking && (NULL != rsp->body_frag_start) && (rsp->body_frag_len > 0)) {
+        download_resume_track(rsp->body_frag_start, rsp->body_frag_len);
+    }
+
+    return download_resume_response(rsp, final_data, user_data);
+}
+
+static void
+download_resume_prepare(struct http_request *req) {
+    if ((HTTP_GET != req->method) || (NULL == req->url) || (NULL != strstr(req->url, DOWNLOAD_RESUME_API_PATH))) {
+        return;
+    }
+
+    /* Pre-signed links of the same artifact only differ by their query */
+    uint32_t hash = 2166136261U;
+    if (NULL != req->host) {
+        hash = download_resume_fnv1a(hash, req->host, strlen(req->host));
+    }
+    hash = download_resume_fnv1a(hash, req->url, strcspn(req->url, "?"));
+
+    download_resume_hash        = hash;
+    download_resume_ranged      = false;
+    download_resume_started     = false;
+    download_resume_tracking    = false;
+    download_resume_received    = 0;
+    download_resume_next_header = 0;
+    download_resume_in_data     = false;
+
+    k_mutex_lock(&download_resume_lock, K_FOREVER);
+    download_resume_armed    = false;
+    download_resume_resuming = false;
+    if (download_resume_saved_valid && (download_resume_saved.url_hash == hash) && (download_resume_saved.committed > 0)) {
+        size_t count = 0;
+        for (; (NULL != req->header_fields) && (NULL != req->header_fields[count]) && (count < DOWNLOAD_RESUME_HEADERS); count++) {
+            download_resume_headers[count] = req->header_fields[count];
+        }
+        snprintf(download_resume_range,
+                 sizeof(download_resume_range),
+                 "Range: bytes=%u-\r\n",
+                 download_resume_saved.payload_start + download_resume_saved.committed);
+        download_resume_headers[count++] = download_resume_range;
+        download_resume_headers[count]   = NULL;
+
+        download_resume_fields = req->header_fields;
+        req->header_fields     = download_resume_headers;
+        download_resume_ranged = true;
+    }
+    k_mutex_unlock(&download_resume_lock);
+
+    download_resume_response = req->response;
+    req->response            = download_resume_response_cb;
+}
+
+static void
+download_resume_complete(struct http_request *req, int ret) {
+    ARG_UNUSED(ret);
+
+    if (download_resume_response_cb != req->response) {
+        return;
+    }
+    req->response = download_resume_response;
+    if (download_resume_ranged) {
+        req->header_fields = download_resume_fields;
+    }
+    download_resume_tracking = false;
+}
+
+static const http_observer_interceptor_t download_resume_interceptor = {
+    .prepare  = download_resume_prepare,
+    .complete = download_resume_complete,
+};
+
+mender_err_t
+download_resume_init(download_resume_read_cb_t read) {
+    assert(NULL != read);
+
+    download_resume_read = read;
+
+    int len = persist_load(DOWNLOAD_RESUME_STATE_KEY, &download_resume_saved, sizeof(download_resume_saved));
+    if (sizeof(download_resume_saved) == len) {
+        download_resume_saved_valid = true;
+        LOG_INF("Interrupted download found, %u bytes of the payload committed", download_resume_saved.committed);
+    } else if (-ENOENT != len) {
+        LOG_WRN("Unable to load the download state: %d", len);
+    }
+
+    return http_observer_intercept(&download_resume_interceptor);
+}
+
+size_t
+download_resume_offset(size_t size) {
+    size_t offset = 0;
+
+    k_mutex_lock(&download_resume_lock, K_FOREVER);
+    if (download_resume_resuming && (download_resume_saved.payload_size == size)) {
+        offset = download_resume_saved.committed;
+    }
+    k_mutex_unlock(&download_resume_lock);
+
+    return offset;
+}
+
+void
+download_resume_commit(size_t offset) {
+    k_mutex_lock(&download_resume_lock, K_FOREVER);
+    if (download_resume_armed && (offset <= download_resume_saved.payload_size)
+        && (offset >= download_resume_saved.committed + CONFIG_MENDER_APP_DOWNLOAD_RESUME_INTERVAL)) {
+        download_resume_saved.committed = (uint32_t)offset;
+        if (0 != persist_save(DOWNLOAD_RESUME_STATE_KEY, &download_resume_saved, sizeof(download_resume_saved))) {
+            LOG_WRN("Unable to save the download state");
+        }
+    }
+    k_mutex_unlock(&download_resume_lock);
+}
+
+void
+download_resume_done(void) {
+    k_mutex_lock(&download_resume_lock, K_FOREVER);
+    download_resume_clear();
+    k_mutex_unlock(&download_resume_lock);
+}
@@ -0,0 +1,69 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DOWNLOAD_RESUME_H__
+#define __DOWNLOAD_RESUME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Read back payload data the Update Module has already stored
+ * @param offset Offset in the payload
+ * @param data Buffer for the data
+ * @param length Number of bytes to read
+ * @return 0 on success, -errno otherwise
+ */
+typedef int (*download_resume_read_cb_t)(size_t offset, void *data, size_t length);
+
+/**
+ * @brief Start resuming the artifact downloads of the client
+ * @param read Read back callback of the Update Module which commits its progress
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note Only one Update Module, writing the payload as-is, can be resumed
+ */
+mender_err_t download_resume_init(download_resume_read_cb_t read);
+
+/**
+ * @brief Offset at which the Update Module resumes writing the payload being downloaded
+ * @param size Size of the payload
+ * @return Offset of the committed data, 0 if the download is not resumed
+ * @note Meant for the first DOWNLOAD callback of the payload. The Update Module still gets the
+ *       data from offset 0, read back from its own storage up to the returned offset.
+ */
+size_t download_resume_offset(size_t size);
+
+/**
+ * @brief Record that the Update Module has durably stored the payload up to offset
+ * @param offset Offset in the payload, everything before it survives a power loss
+ * @note Saved every CONFIG_MENDER_APP_DOWNLOAD_RESUME_INTERVAL bytes, may be called more often
+ */
+void download_resume_commit(size_t offset);
+
+/**
+ * @brief Forget the download, called once the payload is completely stored
+ */
+void download_resume_done(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DOWNLOAD_RESUME_H__ */
@@ -0,0 +1,67 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+#include "download-stage.h"
+
+#include <assert.h>
+
+mender_err_t
+download_stage_forward_reset(download_stage_t *stage, download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    assert(NULL != stage);
+
+    if (NULL != stage->ops->reset) {
+        stage->ops->reset();
+    }
+
+    /* The module may not care about this state at all */
+    if (NULL == next) {
+        return MENDER_OK;
+    }
+    return next(state, callback_data);
+}
+
+mender_err_t
+download_stage_wrap(download_stage_t *stage, const char *artifact_type) {
+    assert(NULL != stage);
+    assert(NULL != artifact_type);
+
+    mender_update_module_t *update_module = mender_update_module_get(artifact_type);
+    if (NULL == update_module) {
+        LOG_ERR("No Update Module registered for '%s'", artifact_type);
+        return MENDER_FAIL;
+    }
+    if (NULL == update_module->callbacks[MENDER_UPDATE_STATE_DOWNLOAD]) {
+        LOG_ERR("Update Module '%s' has no download callback", artifact_type);
+        return MENDER_FAIL;
+    }
+    if (stage->count >= DOWNLOAD_STAGE_MAX_MODULES) {
+        LOG_ERR("Download stage '%s' cannot wrap more than %d Update Modules", stage->ops->name, DOWNLOAD_STAGE_MAX_MODULES);
+        return MENDER_FAIL;
+    }
+
+    size_t i                  = stage->count++;
+    stage->next_download[i]   = update_module->callbacks[MENDER_UPDATE_STATE_DOWNLOAD];
+    stage->next_cleanup[i]    = update_module->callbacks[MENDER_UPDATE_STATE_CLEANUP];
+    stage->next_failure[i]    = update_module->callbacks[MENDER_UPDATE_STATE_FAILURE];
+    update_module->callbacks[MENDER_UPDATE_STATE_DOWNLOAD] = stage->download_trampolines[i];
+    update_module->callbacks[MENDER_UPDATE_STATE_CLEANUP]  = stage->cleanup_trampolines[i];
+    update_module->callbacks[MENDER_UPDATE_STATE_FAILURE]  = stage->failure_trampolines[i];
+
+    LOG_INF("Download stage '%s' wrapped around Update Module '%s'", stage->ops->name, artifact_type);
+
+    return MENDER_OK;
+}
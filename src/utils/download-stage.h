@@ -0,0 +1,117 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __DOWNLOAD_STAGE_H__
+#define __DOWNLOAD_STAGE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <mender/utils.h>
+#include <mender/update-module.h>
+
+#include <zephyr/sys/util.h>
+
+/* A download stage sits between the Mender client and the DOWNLOAD callback of an already
+ * registered Update Module. The update state callbacks carry no user context, so each stage gets
+ * a small, fixed set of trampolines (one per wrapped module) which remember the callbacks they
+ * replaced. Stages can be stacked: wrapping an already wrapped module makes the previous stage
+ * the "next" callback of the new one. */
+
+#define DOWNLOAD_STAGE_MAX_MODULES CONFIG_MENDER_APP_UPDATE_MODULES_MAX
+
+typedef mender_err_t (*download_stage_cb_t)(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+/**
+ * @brief Stage implementation
+ * @note download is called for every MENDER_UPDATE_STATE_DOWNLOAD invocation and must forward the
+ *       data to next (possibly later, possibly transformed). reset, if set, is called before the
+ *       module sees MENDER_UPDATE_STATE_CLEANUP or MENDER_UPDATE_STATE_FAILURE so that the stage
+ *       can drop whatever it still holds from an interrupted download.
+ */
+typedef struct {
+    const char *name;
+    mender_err_t (*download)(download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data);
+    void (*reset)(void);
+} download_stage_ops_t;
+
+typedef struct {
+    const download_stage_ops_t *ops;
+    const download_stage_cb_t  *download_trampolines;
+    const download_stage_cb_t  *cleanup_trampolines;
+    const download_stage_cb_t  *failure_trampolines;
+    download_stage_cb_t        *next_download;
+    download_stage_cb_t        *next_cleanup;
+    download_stage_cb_t        *next_failure;
+    size_t                      count;
+} download_stage_t;
+
+/* Internal helpers for DOWNLOAD_STAGE_DEFINE */
+mender_err_t download_stage_forward_reset(download_stage_t *stage, download_stage_cb_t next, mender_update_state_t state, mender_update_state_data_t callback_data);
+
+#define DOWNLOAD_STAGE_TRAMPOLINES_(_i, _name)                                                                                           \
+    static mender_err_t _name##_download_##_i(mender_update_state_t state, mender_update_state_data_t callback_data) {                 \
+        return _name.ops->download(_name.next_download[_i], state, callback_data);                                                     \
+    }                                                                                                                                    \
+    static mender_err_t _name##_cleanup_##_i(mender_update_state_t state, mender_update_state_data_t callback_data) {                  \
+        return download_stage_forward_reset(&_name, _name.next_cleanup[_i], state, callback_data);                                     \
+    }                                                                                                                                    \
+    static mender_err_t _name##_failure_##_i(mender_update_state_t state, mender_update_state_data_t callback_data) {                  \
+        return download_stage_forward_reset(&_name, _name.next_failure[_i], state, callback_data);                                     \
+    }
+
+#define DOWNLOAD_STAGE_DOWNLOAD_(_i, _name) _name##_download_##_i
+#define DOWNLOAD_STAGE_CLEANUP_(_i, _name)  _name##_cleanup_##_i
+#define DOWNLOAD_STAGE_FAILURE_(_i, _name)  _name##_failure_##_i
+
+/**
+ * @brief Define a download stage named _name backed by the given download_stage_ops_t
+ */
+#define DOWNLOAD_STAGE_DEFINE(_name, _ops)                                                                                               \
+    static download_stage_t    _name;                                                                                                    \
+    static download_stage_cb_t _name##_next_download[DOWNLOAD_STAGE_MAX_MODULES];                                                       \
+    static download_stage_cb_t _name##_next_cleanup[DOWNLOAD_STAGE_MAX_MODULES];                                                        \
+    static download_stage_cb_t _name##_next_failure[DOWNLOAD_STAGE_MAX_MODULES];                                                        \
+    LISTIFY(DOWNLOAD_STAGE_MAX_MODULES, DOWNLOAD_STAGE_TRAMPOLINES_, (), _name)                                                        \
+    static const download_stage_cb_t _name##_download_trampolines[DOWNLOAD_STAGE_MAX_MODULES]                                          \
+        = { LISTIFY(DOWNLOAD_STAGE_MAX_MODULES, DOWNLOAD_STAGE_DOWNLOAD_, (, ), _name) };                                              \
+    static const download_stage_cb_t _name##_cleanup_trampolines[DOWNLOAD_STAGE_MAX_MODULES]                                           \
+        = { LISTIFY(DOWNLOAD_STAGE_MAX_MODULES, DOWNLOAD_STAGE_CLEANUP_, (, ), _name) };                                               \
+    static const download_stage_cb_t _name##_failure_trampolines[DOWNLOAD_STAGE_MAX_MODULES]                                           \
+        = { LISTIFY(DOWNLOAD_STAGE_MAX_MODULES, DOWNLOAD_STAGE_FAILURE_, (, ), _name) };                                               \
+    static download_stage_t _name = {                                                                                                    \
+        .ops                  = (_ops),                                                                                                  \
+        .download_trampolines = _name##_download_trampolines,                                                                            \
+        .cleanup_trampolines  = _name##_cleanup_trampolines,                                                                             \
+        .failure_trampolines  = _name##_failure_trampolines,                                                                             \
+        .next_download        = _name##_next_download,                                                                                   \
+        .next_cleanup         = _name##_next_cleanup,                                                                                    \
+        .next_failure         = _name##_next_failure,                                                                                    \
+        .count                = 0,                                                                                                       \
+    }
+
+/**
+ * @brief Insert a download stage in front of the callbacks of a registered Update Module
+ * @param stage Stage defined with DOWNLOAD_STAGE_DEFINE
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL if the module is unknown or the stage is full
+ */
+mender_err_t download_stage_wrap(download_stage_t *stage, const char *artifact_type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DOWNLOAD_STAGE_H__ */
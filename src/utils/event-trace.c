@@ -0,0 +1,320 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Structured trace of the events of the client, for tests and measurements, apart from the logs.
+ * Events are copied into a ring under a spinlock and written out by a thread of their own:
+ *
+ *  - native_sim: to the host file descriptor given with --trace-fd=<fd>, nothing is recorded
+ *    without it. The host side should make the descriptor non-blocking, a blocking write stops the
+ *    whole simulation; events are dropped instead.
+ *  - UART: to the UART chosen as mender,trace-uart in the devicetree.
+ *  - RTT: to an up buffer of its own, in the non-blocking mode.
+ *
+ * The update state callbacks carry no user context, so like the download stages each traced
+ * Update Module gets a trampoline of its own, which remembers the callbacks it replaced. */
+
+#include "event-trace.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include <mender/update-module.h>
+
+#ifdef CONFIG_MENDER_APP_HTTP_OBSERVER
+#include "http-observer.h"
+#endif /* CONFIG_MENDER_APP_HTTP_OBSERVER */
+
+#ifdef CONFIG_MENDER_APP_MEM_POOL
+#include "mem-pool.h"
+#endif /* CONFIG_MENDER_APP_MEM_POOL */
+
+#ifdef CONFIG_MBEDTLS_ENABLE_HEAP
+#include <mbedtls/memory_buffer_alloc.h>
+#endif /* CONFIG_MBEDTLS_ENABLE_HEAP */
+
+#if defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_NATIVE)
+#include "cmdline.h"
+#include "nsi_host_trampolines.h"
+#include "posix_native_task.h"
+#elif defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_UART)
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#elif defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_RTT)
+#include <SEGGER_RTT.h>
+#endif
+
+#define EVENT_TRACE_SIZE           16
+#define EVENT_TRACE_MAX_MODULES    CONFIG_MENDER_APP_UPDATE_MODULES_MAX
+#define EVENT_TRACE_UPDATE_STATES  ARRAY_SIZE(((mender_update_module_t *)NULL)->callbacks)
+#define EVENT_TRACE_WRITER_STACK   1024
+#define EVENT_TRACE_WRITER_PRIO    K_LOWEST_APPLICATION_THREAD_PRIO
+
+RING_BUF_DECLARE(event_trace_ring, CONFIG_MENDER_APP_EVENT_TRACE_BUFFER_SIZE);
+
+static struct k_spinlock event_trace_lock;
+static uint16_t          event_trace_sequence;
+static bool              event_trace_enabled = !IS_ENABLED(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_NATIVE);
+
+static K_SEM_DEFINE(event_trace_sem, 0, 1);
+
+#ifdef CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_NATIVE
+static int event_trace_fd = -1;
+
+static void
+event_trace_fd_found(char *argv, int offset) {
+    ARG_UNUSED(argv);
+    ARG_UNUSED(offset);
+
+    event_trace_enabled = (event_trace_fd >= 0);
+}
+
+static void
+event_trace_add_options(void) {
+    static struct args_struct_t event_trace_options[] = {
+        { .option          = "trace-fd",
+          .name            = "fd",
+          .type            = 'i',
+          .dest            = (void *)&event_trace_fd,
+          .call_when_found = event_trace_fd_found,
+          .descript        = "Host file descriptor the event trace is written to" },
+        ARG_TABLE_ENDMARKER,
+    };
+
+    native_add_command_line_opts(event_trace_options);
+}
+
+NATIVE_TASK(event_trace_add_options, PRE_BOOT_1, 10);
+
+static void
+event_trace_write(const uint8_t *data, size_t len) {
+    /* Written whole or not at all: writes to a pipe up to PIPE_BUF bytes are atomic, and the
+     * events of a full pipe are lost */
+    (void)nsi_host_write(event_trace_fd, (void *)data, len);
+}
+#elif defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_UART)
+static const struct device *const event_trace_uart = DEVICE_DT_GET(DT_CHOSEN(mender_trace_uart));
+
+static void
+event_trace_write(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(event_trace_uart, data[i]);
+    }
+}
+#elif defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_RTT)
+static uint8_t event_trace_rtt_buffer[CONFIG_MENDER_APP_EVENT_TRACE_RTT_BUFFER_SIZE];
+
+static void
+event_trace_write(const uint8_t *data, size_t len) {
+    SEGGER_RTT_Write(CONFIG_MENDER_APP_EVENT_TRACE_RTT_CHANNEL, data, len);
+}
+#endif
+
+static void
+event_trace_writer(void *p1, void *p2, void *p3) {
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    uint8_t data[EVENT_TRACE_SIZE * 8];
+
+    while (true) {
+        k_sem_take(&event_trace_sem, K_FOREVER);
+
+        uint32_t len;
+        while (0 < (len = ring_buf_get(&event_trace_ring, data, sizeof(data)))) {
+            event_trace_write(data, len);
+        }
+    }
+}
+
+K_THREAD_DEFINE(event_trace_thread, EVENT_TRACE_WRITER_STACK, event_trace_writer, NULL, NULL, NULL, EVENT_TRACE_WRITER_PRIO, 0, 0);
+
+void
+event_trace_emit(event_trace_type_t type, uint32_t a, uint32_t b) {
+    uint8_t event[EVENT_TRACE_SIZE];
+
+    if (!event_trace_enabled) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&event_trace_lock);
+    if (ring_buf_space_get(&event_trace_ring) < EVENT_TRACE_SIZE) {
+        /* The gap in the sequence tells the decoder */
+        event_trace_sequence++;
+        k_spin_unlock(&event_trace_lock, key);
+        return;
+    }
+    event[0] = EVENT_TRACE_SYNC;
+    event[1] = (uint8_t)type;
+    sys_put_le16(event_trace_sequence++, &event[2]);
+    sys_put_le32((uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()), &event[4]);
+    sys_put_le32(a, &event[8]);
+    sys_put_le32(b, &event[12]);
+    ring_buf_put(&event_trace_ring, event, sizeof(event));
+    k_spin_unlock(&event_trace_lock, key);
+
+    k_sem_give(&event_trace_sem);
+}
+
+/* Update Module trampolines */
+
+typedef mender_err_t (*event_trace_cb_t)(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static event_trace_cb_t event_trace_next[EVENT_TRACE_MAX_MODULES][EVENT_TRACE_UPDATE_STATES];
+static size_t           event_trace_count;
+
+static mender_err_t
+event_trace_update_state(size_t module, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+
+    if ((MENDER_UPDATE_STATE_DOWNLOAD == state) && (NULL != dl_data->filename)) {
+        event_trace_emit(EVENT_TRACE_DOWNLOAD, (uint32_t)dl_data->length, (uint32_t)dl_data->offset);
+        /* Only the first and the last block of a payload mark the state */
+        if ((0 != dl_data->offset) && !dl_data->done) {
+            return event_trace_next[module][state](state, callback_data);
+        }
+    }
+
+    event_trace_emit(EVENT_TRACE_UPDATE_STATE_ENTER, state, 0);
+    mender_err_t ret = event_trace_next[module][state](state, callback_data);
+    event_trace_emit(EVENT_TRACE_UPDATE_STATE_EXIT, state, (uint32_t)ret);
+
+    return ret;
+}
+
+#define EVENT_TRACE_TRAMPOLINE(_i, _)                                                                                \
+    static mender_err_t event_trace_update_state_##_i(mender_update_state_t state, mender_update_state_data_t data) { \
+        return event_trace_update_state(_i, state, data);                                                            \
+    }
+#define EVENT_TRACE_TRAMPOLINE_NAME(_i, _) event_trace_update_state_##_i
+
+LISTIFY(EVENT_TRACE_MAX_MODULES, EVENT_TRACE_TRAMPOLINE, ())
+
+static const event_trace_cb_t event_trace_trampolines[EVENT_TRACE_MAX_MODULES]
+    = { LISTIFY(EVENT_TRACE_MAX_MODULES, EVENT_TRACE_TRAMPOLINE_NAME, (, )) };
+
+mender_err_t
+event_trace_wrap(const char *artifact_type) {
+    assert(NULL != artifact_type);
+
+    mender_update_module_t *update_module = mender_update_module_get(artifact_type);
+    if (NULL == update_module) {
+        LOG_ERR("No Update Module registered for '%s'", artifact_type);
+        return MENDER_FAIL;
+    }
+    if (event_trace_count >= EVENT_TRACE_MAX_MODULES) {
+        LOG_ERR("Cannot trace more than %d Update Modules", EVENT_TRACE_MAX_MODULES);
+        return MENDER_FAIL;
+    }
+
+    size_t i = event_trace_count++;
+    for (size_t state = 0; state < EVENT_TRACE_UPDATE_STATES; state++) {
+        /* The client skips the states without a callback, they stay so */
+        event_trace_next[i][state] = update_module->callbacks[state];
+        if (NULL != update_module->callbacks[state]) {
+            update_module->callbacks[state] = event_trace_trampolines[i];
+        }
+    }
+
+    return MENDER_OK;
+}
+
+#ifdef CONFIG_MENDER_APP_HTTP_OBSERVER
+static void
+event_trace_http_cb(const struct http_request *req, uint16_t status, uint32_t retry_after) {
+    ARG_UNUSED(retry_after);
+
+    event_trace_endpoint_t endpoint = EVENT_TRACE_ENDPOINT_OTHER;
+
+    if (NULL != req->url) {
+        if (NULL != strstr(req->url, "/authentication/auth_requests")) {
+            endpoint = EVENT_TRACE_ENDPOINT_AUTH;
+        } else if (NULL != strstr(req->url, "/deployments/next")) {
+            endpoint = EVENT_TRACE_ENDPOINT_NEXT;
+        } else if (NULL != strstr(req->url, "/status")) {
+            endpoint = EVENT_TRACE_ENDPOINT_STATUS;
+        } else if (NULL != strstr(req->url, "/log")) {
+            endpoint = EVENT_TRACE_ENDPOINT_LOG;
+        } else if (NULL != strstr(req->url, "/inventory/")) {
+            endpoint = EVENT_TRACE_ENDPOINT_INVENTORY;
+        }
+    }
+    event_trace_emit(EVENT_TRACE_HTTP_RESPONSE, status, endpoint);
+}
+#endif /* CONFIG_MENDER_APP_HTTP_OBSERVER */
+
+#if CONFIG_MENDER_APP_EVENT_TRACE_HEAP_INTERVAL > 0
+static void
+event_trace_heap_handler(struct k_work *work) {
+#if defined(CONFIG_MBEDTLS_ENABLE_HEAP) && defined(MBEDTLS_MEMORY_DEBUG)
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+    event_trace_emit(EVENT_TRACE_HEAP_TLS, (uint32_t)used, (uint32_t)blocks);
+#endif /* CONFIG_MBEDTLS_ENABLE_HEAP && MBEDTLS_MEMORY_DEBUG */
+#ifdef CONFIG_MENDER_APP_MEM_POOL
+    mem_pool_stats_t stats;
+    uint32_t         pools = 0;
+    for (int pool_class = 0; pool_class < MEM_POOL_CLASS_HEAP; pool_class++) {
+        mem_pool_get_stats((mem_pool_class_t)pool_class, &stats);
+        pools += stats.current;
+    }
+    mem_pool_get_stats(MEM_POOL_CLASS_HEAP, &stats);
+    event_trace_emit(EVENT_TRACE_HEAP_POOL, pools, stats.current);
+#endif /* CONFIG_MENDER_APP_MEM_POOL */
+
+    k_work_schedule(k_work_delayable_from_work(work), K_MSEC(CONFIG_MENDER_APP_EVENT_TRACE_HEAP_INTERVAL));
+}
+
+static K_WORK_DELAYABLE_DEFINE(event_trace_heap_work, event_trace_heap_handler);
+#endif /* CONFIG_MENDER_APP_EVENT_TRACE_HEAP_INTERVAL > 0 */
+
+mender_err_t
+event_trace_init(void) {
+#if defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_UART)
+    if (!device_is_ready(event_trace_uart)) {
+        LOG_ERR("Event trace UART is not ready");
+        return MENDER_FAIL;
+    }
+#elif defined(CONFIG_MENDER_APP_EVENT_TRACE_BACKEND_RTT)
+    SEGGER_RTT_ConfigUpBuffer(CONFIG_MENDER_APP_EVENT_TRACE_RTT_CHANNEL,
+                              "mender-trace",
+                              event_trace_rtt_buffer,
+                              sizeof(event_trace_rtt_buffer),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+
+    event_trace_emit(EVENT_TRACE_BOOT, EVENT_TRACE_VERSION, 0);
+
+#ifdef CONFIG_MENDER_APP_HTTP_OBSERVER
+    if (MENDER_OK != http_observer_add(event_trace_http_cb)) {
+        return MENDER_FAIL;
+    }
+#endif /* CONFIG_MENDER_APP_HTTP_OBSERVER */
+
+#if CONFIG_MENDER_APP_EVENT_TRACE_HEAP_INTERVAL > 0
+    if (event_trace_enabled) {
+        k_work_schedule(&event_trace_heap_work, K_NO_WAIT);
+    }
+#endif /* CONFIG_MENDER_APP_EVENT_TRACE_HEAP_INTERVAL > 0 */
+
+    return MENDER_OK;
+}
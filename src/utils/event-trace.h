@@ -0,0 +1,111 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __EVENT_TRACE_H__
+#define __EVENT_TRACE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+/* Events are 16 byte records, little endian, see tests/integration/device.py for the decoder:
+ *
+ *   sync (0xa5) | type (1 byte) | sequence (2 bytes) | timestamp in us (4 bytes) | a (4 bytes) | b (4 bytes)
+ *
+ * The sequence numbers the events, gaps are events dropped when the buffer was full. */
+
+#define EVENT_TRACE_SYNC    0xa5
+#define EVENT_TRACE_VERSION 1
+
+/**
+ * @brief Event types, with the meaning of their a and b values
+ */
+typedef enum {
+    EVENT_TRACE_BOOT = 1,           /**< a: EVENT_TRACE_VERSION */
+    EVENT_TRACE_NETWORK,            /**< a: 1 on connect, 0 on release */
+    EVENT_TRACE_HTTP_RESPONSE,      /**< a: status, b: event_trace_endpoint_t */
+    EVENT_TRACE_DEPLOYMENT_STATUS,  /**< a: mender_deployment_status_t */
+    EVENT_TRACE_UPDATE_STATE_ENTER, /**< a: mender_update_state_t */
+    EVENT_TRACE_UPDATE_STATE_EXIT,  /**< a: mender_update_state_t, b: mender_err_t returned */
+    EVENT_TRACE_DOWNLOAD,           /**< a: bytes received, b: offset in the payload */
+    EVENT_TRACE_HEAP_TLS,           /**< a: bytes of the mbedTLS heap in use, b: blocks */
+    EVENT_TRACE_HEAP_POOL,          /**< a: pool allocations in use, b: heap allocations in use */
+} event_trace_type_t;
+
+/**
+ * @brief Requests of the client, as told apart by their URL
+ */
+typedef enum {
+    EVENT_TRACE_ENDPOINT_OTHER = 0,
+    EVENT_TRACE_ENDPOINT_AUTH,
+    EVENT_TRACE_ENDPOINT_NEXT,
+    EVENT_TRACE_ENDPOINT_STATUS,
+    EVENT_TRACE_ENDPOINT_LOG,
+    EVENT_TRACE_ENDPOINT_INVENTORY,
+} event_trace_endpoint_t;
+
+#ifdef CONFIG_MENDER_APP_EVENT_TRACE
+
+/**
+ * @brief Start the trace: observe the responses to the client and sample the heaps
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ */
+mender_err_t event_trace_init(void);
+
+/**
+ * @brief Trace the update state callbacks of a registered Update Module, and the data it receives
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL if the module is unknown or too many are traced
+ * @note Wrap the module last, after the download stages, to see the data as it is received
+ */
+mender_err_t event_trace_wrap(const char *artifact_type);
+
+/**
+ * @brief Record an event
+ * @note Cheap enough to be called from any thread: the event is copied into a buffer, which is
+ *       written out from a thread of its own. Events are dropped when the buffer is full.
+ */
+void event_trace_emit(event_trace_type_t type, uint32_t a, uint32_t b);
+
+#else
+
+static inline mender_err_t
+event_trace_init(void) {
+    return MENDER_OK;
+}
+
+static inline mender_err_t
+event_trace_wrap(const char *artifact_type) {
+    (void)artifact_type;
+    return MENDER_OK;
+}
+
+static inline void
+event_trace_emit(event_trace_type_t type, uint32_t a, uint32_t b) {
+    (void)type;
+    (void)a;
+    (void)b;
+}
+
+#endif /* CONFIG_MENDER_APP_EVENT_TRACE */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EVENT_TRACE_H__ */
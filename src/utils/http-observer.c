@@ -0,0 +1,168 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The status is read from the response parsed by http_client_req(). The Retry-After header is
+ * captured with the parser callbacks of the request, which the HTTP client calls in addition to
+ * its own ones; requests which already have some set are left alone, without Retry-After then. */
+
+#include "http-observer.h"
+
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+
+#define HTTP_OBSERVER_RETRY_AFTER     "Retry-After"
+#define HTTP_OBSERVER_RETRY_AFTER_MAX 86400
+
+static http_observer_cb_t http_observer_callbacks[HTTP_OBSERVER_MAX];
+static size_t             http_observer_count;
+
+static const http_observer_interceptor_t *http_observer_interceptors[HTTP_OBSERVER_MAX];
+static size_t                             http_observer_interceptor_count;
+
+static K_MUTEX_DEFINE(http_observer_lock);
+
+/* Retry-After of the response being parsed, only the client thread sends requests */
+static bool     http_observer_in_retry_after;
+static uint32_t http_observer_retry_after;
+
+int __real_http_client_req(int sock, struct http_request *req, int32_t timeout, void *user_data);
+
+static int
+http_observer_on_header_field(struct http_parser *parser, const char *at, size_t length) {
+    ARG_UNUSED(parser);
+
+    http_observer_in_retry_after
+        = (strlen(HTTP_OBSERVER_RETRY_AFTER) == length) && (0 == strncasecmp(at, HTTP_OBSERVER_RETRY_AFTER, length));
+
+    return 0;
+}
+
+static int
+http_observer_on_header_value(struct http_parser *parser, const char *at, size_t length) {
+    ARG_UNUSED(parser);
+
+    if (!http_observer_in_retry_after) {
+        return 0;
+    }
+
+    /* Only the delay-seconds form */
+    uint32_t seconds = 0;
+    for (size_t i = 0; i < length; i++) {
+        if ((at[i] < '0') || (at[i] > '9')) {
+            return 0;
+        }
+        seconds = MIN(seconds * 10 + (at[i] - '0'), HTTP_OBSERVER_RETRY_AFTER_MAX);
+    }
+    http_observer_retry_after = seconds;
+
+    return 0;
+}
+
+static const struct http_parser_settings http_observer_parser_settings = {
+    .on_header_field = http_observer_on_header_field,
+    .on_header_value = http_observer_on_header_value,
+};
+
+int
+__wrap_http_client_req(int sock, struct http_request *req, int32_t timeout, void *user_data) {
+    if (NULL == req->http_cb) {
+        req->http_cb = &http_observer_parser_settings;
+    }
+    http_observer_in_retry_after = false;
+    http_observer_retry_after    = 0;
+
+    /* Only added before the client is activated */
+    size_t count    = http_observer_interceptor_count;
+    int    ret      = -1;
+    bool   answered = false;
+
+    for (size_t i = 0; (i < count) && !answered; i++) {
+        if (NULL != http_observer_interceptors[i]->answer) {
+            answered = ((ret = http_observer_interceptors[i]->answer(req, user_data)) >= 0);
+        }
+    }
+
+    if (!answered) {
+        for (size_t i = 0; i < count; i++) {
+            if (NULL != http_observer_interceptors[i]->prepare) {
+                http_observer_interceptors[i]->prepare(req);
+            }
+        }
+
+        ret = __real_http_client_req(sock, req, timeout, user_data);
+
+        for (size_t i = count; i > 0; i--) {
+            if (NULL != http_observer_interceptors[i - 1]->complete) {
+                http_observer_interceptors[i - 1]->complete(req, ret);
+            }
+        }
+    }
+
+    if (&http_observer_parser_settings == req->http_cb) {
+        req->http_cb = NULL;
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    k_mutex_lock(&http_observer_lock, K_FOREVER);
+    for (size_t i = 0; i < http_observer_count; i++) {
+        http_observer_callbacks[i](req, req->internal.response.http_status_code, http_observer_retry_after);
+    }
+    k_mutex_unlock(&http_observer_lock);
+
+    return ret;
+}
+
+mender_err_t
+http_observer_add(http_observer_cb_t callback) {
+    assert(NULL != callback);
+
+    mender_err_t ret = MENDER_FAIL;
+
+    k_mutex_lock(&http_observer_lock, K_FOREVER);
+    if (http_observer_count < HTTP_OBSERVER_MAX) {
+        http_observer_callbacks[http_observer_count++] = callback;
+        ret                                            = MENDER_OK;
+    } else {
+        LOG_ERR("Too many HTTP observers, the limit is %d", HTTP_OBSERVER_MAX);
+    }
+    k_mutex_unlock(&http_observer_lock);
+
+    return ret;
+}
+
+mender_err_t
+http_observer_intercept(const http_observer_interceptor_t *interceptor) {
+    assert(NULL != interceptor);
+
+    mender_err_t ret = MENDER_FAIL;
+
+    k_mutex_lock(&http_observer_lock, K_FOREVER);
+    if (http_observer_interceptor_count < HTTP_OBSERVER_MAX) {
+        http_observer_interceptors[http_observer_interceptor_count++] = interceptor;
+        ret                                                           = MENDER_OK;
+    } else {
+        LOG_ERR("Too many HTTP interceptors, the limit is %d", HTTP_OBSERVER_MAX);
+    }
+    k_mutex_unlock(&http_observer_lock);
+
+    return ret;
+}
@@ -0,0 +1,76 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __HTTP_OBSERVER_H__
+#define __HTTP_OBSERVER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <zephyr/net/http/client.h>
+
+#include <mender/utils.h>
+
+/* The Mender client does not report the responses of the server to the application. The
+ * application is linked with --wrap=http_client_req, and the observers added here are called
+ * with the status of every request of the client that got a response. Interceptors can also
+ * change the requests before they are sent and their response callback, or answer them without
+ * sending them. */
+
+#define HTTP_OBSERVER_MAX 4
+
+/**
+ * @brief Response to a request of the client
+ * @param req Request, url and method are the ones of the client
+ * @param status HTTP status code
+ * @param retry_after Seconds of the Retry-After header, 0 if it has none or is an HTTP-date
+ * @note Called from the client thread, right after the response is received
+ */
+typedef void (*http_observer_cb_t)(const struct http_request *req, uint16_t status, uint32_t retry_after);
+
+/**
+ * @brief Add an observer
+ * @return MENDER_OK on success, MENDER_FAIL if more than HTTP_OBSERVER_MAX are added
+ */
+mender_err_t http_observer_add(http_observer_cb_t callback);
+
+/**
+ * @brief Interceptor of the requests of the client
+ * @note answer, if set, is called first and may answer the request itself: it then fills
+ *       req->internal.response, calls the response callback of the request, and returns what
+ *       http_client_req() returns, the request is not sent. It returns a negative value
+ *       otherwise. prepare is called before the request is sent and may change it, complete right
+ *       after http_client_req() returns, before the observers, with its return value, to undo
+ *       the changes. All are called from the client thread, and can be NULL.
+ */
+typedef struct {
+    int (*answer)(struct http_request *req, void *user_data);
+    void (*prepare)(struct http_request *req);
+    void (*complete)(struct http_request *req, int ret);
+} http_observer_interceptor_t;
+
+/**
+ * @brief Add an interceptor
+ * @return MENDER_OK on success, MENDER_FAIL if more than HTTP_OBSERVER_MAX are added
+ */
+mender_err_t http_observer_intercept(const http_observer_interceptor_t *interceptor);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HTTP_OBSERVER_H__ */
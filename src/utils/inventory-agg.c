@@ -0,0 +1,197 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The client sends the whole inventory every CONFIG_MENDER_CLIENT_INVENTORY_REFRESH_INTERVAL
+ * seconds, changed or not. The callbacks added here are registered with the client as a single
+ * one, and their data is hashed every CONFIG_MENDER_APP_INVENTORY_AGG_CHECK_INTERVAL seconds: an
+ * inventory update is only triggered when the hash differs from the one the server last
+ * acknowledged with a 2xx answer to the inventory PUT. With a long refresh interval, which acts
+ * as a heartbeat, devices whose inventory does not change rarely send it.
+ *
+ * The hash is computed over the inventory serialized as the client sends it, fed to the hash as it
+ * is serialized: checking costs neither an allocation nor a buffer. */
+
+#include "inventory-agg.h"
+#include "inventory-json.h"
+#include "http-observer.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+
+#include <mender/inventory.h>
+
+#define FNV1A_OFFSET 0x811c9dc5u
+#define FNV1A_PRIME  0x01000193u
+
+static inventory_agg_cb_t inventory_agg_callbacks[CONFIG_MENDER_APP_INVENTORY_AGG_MAX_CALLBACKS];
+static size_t             inventory_agg_count;
+
+static K_MUTEX_DEFINE(inventory_agg_lock);
+
+/* Data handed to the client, valid until the next collection */
+static mender_keystore_t inventory_agg_keystore[CONFIG_MENDER_APP_INVENTORY_AGG_MAX_ENTRIES];
+static uint8_t           inventory_agg_len;
+
+/* Length of the serialized inventory */
+static ssize_t inventory_agg_json_len;
+
+/* Hash of the inventory last handed to the client, and of the one the server acknowledged */
+static uint32_t inventory_agg_handed;
+static bool     inventory_agg_handed_valid;
+static uint32_t inventory_agg_sent;
+static bool     inventory_agg_sent_valid;
+static bool     inventory_agg_started;
+
+static void inventory_agg_check_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(inventory_agg_check_work, inventory_agg_check_work_handler);
+
+static bool
+inventory_agg_fnv1a(const char *data, size_t len, void *user_data) {
+    uint32_t *hash = user_data;
+
+    for (size_t i = 0; i < len; i++) {
+        *hash = (*hash ^ (uint8_t)data[i]) * FNV1A_PRIME;
+    }
+
+    return true;
+}
+
+/* Gathers the data of all the callbacks, must be called with the lock held */
+static mender_err_t
+inventory_agg_collect(uint32_t *hash) {
+    mender_keystore_t *keystore;
+    uint8_t            len;
+
+    inventory_agg_len = 0;
+
+    for (size_t i = 0; i < inventory_agg_count; i++) {
+        if (MENDER_OK != inventory_agg_callbacks[i](&keystore, &len)) {
+            return MENDER_FAIL;
+        }
+        for (uint8_t j = 0; j < len; j++) {
+            if (inventory_agg_len >= CONFIG_MENDER_APP_INVENTORY_AGG_MAX_ENTRIES) {
+                LOG_ERR("Too many inventory entries, the limit is %d", CONFIG_MENDER_APP_INVENTORY_AGG_MAX_ENTRIES);
+                return MENDER_FAIL;
+            }
+            inventory_agg_keystore[inventory_agg_len++] = keystore[j];
+        }
+    }
+
+    *hash                  = FNV1A_OFFSET;
+    inventory_agg_json_len = inventory_json_stream(inventory_agg_keystore, inventory_agg_len, inventory_agg_fnv1a, hash);
+
+    return MENDER_OK;
+}
+
+static mender_err_t
+inventory_agg_cb(mender_keystore_t **keystore, uint8_t *keystore_len) {
+    uint32_t     hash;
+    mender_err_t ret;
+
+    k_mutex_lock(&inventory_agg_lock, K_FOREVER);
+    if (MENDER_OK == (ret = inventory_agg_collect(&hash))) {
+        inventory_agg_handed       = hash;
+        inventory_agg_handed_valid = true;
+        inventory_agg_started      = true;
+        *keystore                  = inventory_agg_keystore;
+        *keystore_len            = inventory_agg_len;
+    }
+    k_mutex_unlock(&inventory_agg_lock);
+
+    return ret;
+}
+
+static void
+inventory_agg_http_cb(const struct http_request *req, uint16_t status, uint32_t retry_after) {
+    ARG_UNUSED(retry_after);
+
+    if ((HTTP_PUT != req->method) || (NULL == req->url) || (NULL == strstr(req->url, "/inventory/device/attributes"))) {
+        return;
+    }
+
+    k_mutex_lock(&inventory_agg_lock, K_FOREVER);
+    if (inventory_agg_handed_valid && (status >= 200) && (status < 300)) {
+        inventory_agg_sent       = inventory_agg_handed;
+        inventory_agg_sent_valid = true;
+    }
+    inventory_agg_handed_valid = false;
+    k_mutex_unlock(&inventory_agg_lock);
+}
+
+static void
+inventory_agg_check_work_handler(struct k_work *work) {
+    ARG_UNUSED(work);
+
+    uint32_t hash;
+    bool     changed = false;
+    ssize_t  len     = 0;
+
+    k_mutex_lock(&inventory_agg_lock, K_FOREVER);
+    /* Before the first update, the client sends the inventory anyway; if the server did not
+       accept any yet, it is sent again */
+    if (inventory_agg_started && (MENDER_OK == inventory_agg_collect(&hash))) {
+        changed = !inventory_agg_sent_valid || (hash != inventory_agg_sent);
+        len     = inventory_agg_json_len;
+    }
+    k_mutex_unlock(&inventory_agg_lock);
+
+    if (changed) {
+        LOG_INF("Inventory changed (%zd bytes), updating", len);
+        if (MENDER_OK != mender_inventory_execute()) {
+            LOG_WRN("Unable to trigger the inventory update");
+        }
+    }
+
+    k_work_reschedule(&inventory_agg_check_work, K_SECONDS(CONFIG_MENDER_APP_INVENTORY_AGG_CHECK_INTERVAL));
+}
+
+mender_err_t
+inventory_agg_add_callback(inventory_agg_cb_t callback) {
+    assert(NULL != callback);
+
+    mender_err_t ret = MENDER_FAIL;
+
+    k_mutex_lock(&inventory_agg_lock, K_FOREVER);
+    if (inventory_agg_count < CONFIG_MENDER_APP_INVENTORY_AGG_MAX_CALLBACKS) {
+        inventory_agg_callbacks[inventory_agg_count++] = callback;
+        ret                                            = MENDER_OK;
+    } else {
+        LOG_ERR("Too many inventory callbacks, the limit is %d", CONFIG_MENDER_APP_INVENTORY_AGG_MAX_CALLBACKS);
+    }
+    k_mutex_unlock(&inventory_agg_lock);
+
+    return ret;
+}
+
+mender_err_t
+inventory_agg_start(void) {
+    mender_err_t ret;
+
+    if (MENDER_OK != (ret = http_observer_add(inventory_agg_http_cb))) {
+        return ret;
+    }
+    /* Persistent: the keystore is static, the client must not free it */
+    if (MENDER_OK != (ret = mender_inventory_add_callback(inventory_agg_cb, true))) {
+        return ret;
+    }
+    k_work_schedule(&inventory_agg_check_work, K_SECONDS(CONFIG_MENDER_APP_INVENTORY_AGG_CHECK_INTERVAL));
+
+    return MENDER_OK;
+}
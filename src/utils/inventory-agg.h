@@ -0,0 +1,52 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __INVENTORY_AGG_H__
+#define __INVENTORY_AGG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Inventory callback, same as the ones of mender_inventory_add_callback()
+ */
+typedef mender_err_t (*inventory_agg_cb_t)(mender_keystore_t **keystore, uint8_t *keystore_len);
+
+/**
+ * @brief Add an inventory callback whose data is watched for changes
+ * @return MENDER_OK on success, MENDER_FAIL if too many callbacks are added
+ * @note The callbacks are also called outside of the inventory updates, to check their data, so
+ *       they must not have side effects
+ */
+mender_err_t inventory_agg_add_callback(inventory_agg_cb_t callback);
+
+/**
+ * @brief Register the aggregated callbacks with the client and start watching them
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note The inventory is sent as soon as the data of a callback changes; otherwise the client
+ *       only sends it every CONFIG_MENDER_CLIENT_INVENTORY_REFRESH_INTERVAL seconds, which then
+ *       bounds how stale the inventory on the server can be
+ */
+mender_err_t inventory_agg_start(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INVENTORY_AGG_H__ */
@@ -0,0 +1,102 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include "inventory-json.h"
+
+#include <errno.h>
+#include <assert.h>
+
+typedef struct {
+    inventory_json_sink_t sink;
+    void                 *user_data;
+    size_t                len;
+} inventory_json_t;
+
+static const char inventory_json_hex[] = "0123456789abcdef";
+
+static bool
+inventory_json_put(inventory_json_t *json, const char *data, size_t len) {
+    if (!json->sink(data, len, json->user_data)) {
+        return false;
+    }
+    json->len += len;
+
+    return true;
+}
+
+static bool
+inventory_json_put_string(inventory_json_t *json, const char *str) {
+    char escape[6] = { '\\', 'u', '0', '0' };
+
+    if (NULL == str) {
+        return inventory_json_put(json, "null", 4);
+    }
+    if (!inventory_json_put(json, "\"", 1)) {
+        return false;
+    }
+    /* Runs of characters that need no escaping go to the sink in one chunk */
+    for (const char *run = str;; str++) {
+        unsigned char c = *str;
+
+        if (('\0' != c) && ('"' != c) && ('\\' != c) && (c >= 0x20)) {
+            continue;
+        }
+        if ((str > run) && !inventory_json_put(json, run, (size_t)(str - run))) {
+            return false;
+        }
+        if ('\0' == c) {
+            break;
+        }
+        if (('"' == c) || ('\\' == c)) {
+            escape[1] = c;
+            if (!inventory_json_put(json, escape, 2)) {
+                return false;
+            }
+        } else {
+            escape[1] = 'u';
+            escape[4] = inventory_json_hex[c >> 4];
+            escape[5] = inventory_json_hex[c & 0xf];
+            if (!inventory_json_put(json, escape, 6)) {
+                return false;
+            }
+        }
+        run = str + 1;
+    }
+
+    return inventory_json_put(json, "\"", 1);
+}
+
+ssize_t
+inventory_json_stream(const mender_keystore_t *keystore, size_t keystore_len, inventory_json_sink_t sink, void *user_data) {
+    assert((NULL != keystore) || (0 == keystore_len));
+    assert(NULL != sink);
+
+    inventory_json_t json = { .sink = sink, .user_data = user_data, .len = 0 };
+
+    if (!inventory_json_put(&json, "[", 1)) {
+        return -ENOSPC;
+    }
+    for (size_t i = 0; i < keystore_len; i++) {
+        if (((i > 0) && !inventory_json_put(&json, ",", 1)) || !inventory_json_put(&json, "{\"name\":", 8)
+            || !inventory_json_put_string(&json, keystore[i].name) || !inventory_json_put(&json, ",\"value\":", 9)
+            || !inventory_json_put_string(&json, keystore[i].value) || !inventory_json_put(&json, "}", 1)) {
+            return -ENOSPC;
+        }
+    }
+    if (!inventory_json_put(&json, "]", 1)) {
+        return -ENOSPC;
+    }
+
+    return (ssize_t)json.len;
+}
@@ -0,0 +1,53 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __INVENTORY_JSON_H__
+#define __INVENTORY_JSON_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Receives the JSON as it is serialized
+ * @param data Next chunk of the JSON, not NUL terminated
+ * @param len Length of the chunk
+ * @param user_data User data given to inventory_json_stream()
+ * @return true to go on, false to stop the serialization
+ */
+typedef bool (*inventory_json_sink_t)(const char *data, size_t len, void *user_data);
+
+/**
+ * @brief Serialize inventory entries as the JSON body of an inventory update, chunk by chunk
+ * @param keystore Inventory entries
+ * @param keystore_len Number of entries
+ * @param sink Called with every chunk, in order
+ * @param user_data Passed to the sink
+ * @return Length of the JSON on success, -ENOSPC if the sink stopped it
+ * @note Nothing is buffered: the chunks are runs of the strings, their escapes and the JSON
+ *       punctuation
+ */
+ssize_t inventory_json_stream(const mender_keystore_t *keystore, size_t keystore_len, inventory_json_sink_t sink, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INVENTORY_JSON_H__ */
@@ -0,0 +1,122 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+/* The swap modes (using move, using offset) go through the Zephyr MCUboot API, which works on the
+ * primary and secondary slots. In direct-XIP mode the flags are written with the bootutil API on
+ * the slot they apply to: MCUboot boots the newest valid image, tries a new one once when it is
+ * marked for test, and invalidates it on the next boot unless it has been confirmed. Only the
+ * direct-XIP mode with revert is supported, without it a failed update cannot be rolled back. */
+
+#include "mcuboot-slot.h"
+
+#include <errno.h>
+
+#include <zephyr/dfu/mcuboot.h>
+#include <zephyr/storage/flash_map.h>
+
+#ifdef CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP
+#include <bootutil/bootutil_public.h>
+
+#ifndef CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP_WITH_REVERT
+#error "Direct-XIP without revert cannot roll back a failed update, use the mode with revert"
+#endif /* CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP_WITH_REVERT */
+#endif /* CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP */
+
+#define MCUBOOT_SLOT_PRIMARY_ID   FIXED_PARTITION_ID(slot0_partition)
+#define MCUBOOT_SLOT_SECONDARY_ID FIXED_PARTITION_ID(slot1_partition)
+
+#ifdef CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP
+
+int
+mcuboot_slot_active_id(void) {
+    return (0 == boot_fetch_active_slot()) ? MCUBOOT_SLOT_PRIMARY_ID : MCUBOOT_SLOT_SECONDARY_ID;
+}
+
+int
+mcuboot_slot_target_id(void) {
+    return (0 == boot_fetch_active_slot()) ? MCUBOOT_SLOT_SECONDARY_ID : MCUBOOT_SLOT_PRIMARY_ID;
+}
+
+static int
+mcuboot_slot_set_next(int id, bool active, bool confirm) {
+    const struct flash_area *fa;
+    int                      rc;
+
+    if (0 != (rc = flash_area_open(id, &fa))) {
+        return rc;
+    }
+    rc = boot_set_next(fa, active, confirm);
+    flash_area_close(fa);
+
+    return (0 == rc) ? 0 : -EIO;
+}
+
+int
+mcuboot_slot_request_test(void) {
+    return mcuboot_slot_set_next(mcuboot_slot_target_id(), false, false);
+}
+
+int
+mcuboot_slot_confirm(void) {
+    return mcuboot_slot_set_next(mcuboot_slot_active_id(), true, true);
+}
+
+bool
+mcuboot_slot_is_confirmed(void) {
+    const struct flash_area *fa;
+    struct boot_swap_state   state;
+    int                      rc;
+
+    if (0 != flash_area_open(mcuboot_slot_active_id(), &fa)) {
+        return false;
+    }
+    rc = boot_read_swap_state(fa, &state);
+    flash_area_close(fa);
+
+    return (0 == rc) && (BOOT_FLAG_SET == state.image_ok);
+}
+
+#else
+
+int
+mcuboot_slot_active_id(void) {
+    return MCUBOOT_SLOT_PRIMARY_ID;
+}
+
+int
+mcuboot_slot_target_id(void) {
+    return MCUBOOT_SLOT_SECONDARY_ID;
+}
+
+int
+mcuboot_slot_request_test(void) {
+    return boot_request_upgrade(BOOT_UPGRADE_TEST);
+}
+
+int
+mcuboot_slot_confirm(void) {
+    return boot_write_img_confirmed();
+}
+
+bool
+mcuboot_slot_is_confirmed(void) {
+    return boot_is_img_confirmed();
+}
+
+#endif /* CONFIG_MCUBOOT_BOOTLOADER_MODE_DIRECT_XIP */
+
+int
+mcuboot_slot_erase_target(void) {
+    return boot_erase_img_bank(mcuboot_slot_target_id());
+}
@@ -0,0 +1,66 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __MCUBOOT_SLOT_H__
+#define __MCUBOOT_SLOT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+
+/* Image slots and test/confirm flags of the MCUboot mode the application is built for. In the
+ * swap modes the image always runs from the primary slot and the new one goes to the secondary
+ * slot. In direct-XIP mode the image runs from the slot it was linked for, the new one goes to
+ * the other slot, and both slots have their own flags. */
+
+/**
+ * @brief Flash area id of the slot the running image is in
+ */
+int mcuboot_slot_active_id(void);
+
+/**
+ * @brief Flash area id of the slot a new image is written to
+ */
+int mcuboot_slot_target_id(void);
+
+/**
+ * @brief Boot the image of the target slot once, MCUboot reverts it if it is not confirmed
+ * @return 0 on success, -errno otherwise
+ */
+int mcuboot_slot_request_test(void);
+
+/**
+ * @brief Confirm the running image
+ * @return 0 on success, -errno otherwise
+ */
+int mcuboot_slot_confirm(void);
+
+/**
+ * @brief Check whether the running image is confirmed
+ */
+bool mcuboot_slot_is_confirmed(void);
+
+/**
+ * @brief Erase the target slot, so that MCUboot does not pick up what was written to it
+ * @return 0 on success, -errno otherwise
+ */
+int mcuboot_slot_erase_target(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __MCUBOOT_SLOT_H__ */
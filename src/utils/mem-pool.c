@@ -0,0 +1,270 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Allocator for the Mender client. Requests are served from the smallest fixed-size block pool
+ * they fit in, or from the next bigger one if it is exhausted, and only go to the heap when they
+ * are bigger than the biggest block or all the pools are exhausted. Pools allocate in constant
+ * time and cannot fragment, so the heap is left to the few big, short lived buffers.
+ *
+ * Every allocation starts with a header giving its class and size, needed to free and reallocate
+ * it. Allocations made during a deployment are marked, those still in use when it ends are
+ * reported: they are either kept by the client on purpose or leaked.
+ *
+ * The heap is the one of the C library, as with the default allocator of the client: the kernel
+ * heap has no size unless CONFIG_HEAP_MEM_POOL_SIZE is set, which the application does not do. */
+
+#include "mem-pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <mender/alloc.h>
+#include <mender/inventory.h>
+
+typedef struct {
+    uint32_t size;
+    uint8_t  class;
+    uint8_t  deployment;
+    uint16_t reserved;
+} mem_pool_header_t;
+
+/* Keeps the user data aligned as the heap would */
+#define MEM_POOL_HEADER_SIZE 8
+BUILD_ASSERT(sizeof(mem_pool_header_t) == MEM_POOL_HEADER_SIZE);
+
+K_MEM_SLAB_DEFINE_STATIC(mem_pool_32, 32, CONFIG_MENDER_APP_MEM_POOL_BLOCKS_32, 8);
+K_MEM_SLAB_DEFINE_STATIC(mem_pool_64, 64, CONFIG_MENDER_APP_MEM_POOL_BLOCKS_64, 8);
+K_MEM_SLAB_DEFINE_STATIC(mem_pool_128, 128, CONFIG_MENDER_APP_MEM_POOL_BLOCKS_128, 8);
+K_MEM_SLAB_DEFINE_STATIC(mem_pool_256, 256, CONFIG_MENDER_APP_MEM_POOL_BLOCKS_256, 8);
+K_MEM_SLAB_DEFINE_STATIC(mem_pool_512, 512, CONFIG_MENDER_APP_MEM_POOL_BLOCKS_512, 8);
+
+static struct k_mem_slab *const mem_pool_slabs[MEM_POOL_CLASS_HEAP] = {
+    &mem_pool_32, &mem_pool_64, &mem_pool_128, &mem_pool_256, &mem_pool_512,
+};
+static const size_t mem_pool_block_sizes[MEM_POOL_CLASS_HEAP] = { 32, 64, 128, 256, 512 };
+
+static const char *mem_pool_names[MEM_POOL_CLASS_COUNT] = {
+    [MEM_POOL_CLASS_32] = "mem_32",   [MEM_POOL_CLASS_64] = "mem_64",   [MEM_POOL_CLASS_128] = "mem_128",
+    [MEM_POOL_CLASS_256] = "mem_256", [MEM_POOL_CLASS_512] = "mem_512", [MEM_POOL_CLASS_HEAP] = "mem_heap",
+};
+
+static struct k_spinlock mem_pool_lock;
+static mem_pool_stats_t  mem_pool_stats[MEM_POOL_CLASS_COUNT];
+
+/* Allocations of the ongoing (or last) deployment */
+static bool     mem_pool_deployment;
+static uint32_t mem_pool_deployment_current;
+static uint32_t mem_pool_deployment_peak;
+
+/* One inventory entry per class, plus the deployment */
+#define MEM_POOL_INVENTORY_LEN (MEM_POOL_CLASS_COUNT + 1)
+static char              mem_pool_inventory_values[MEM_POOL_INVENTORY_LEN][32];
+static mender_keystore_t mem_pool_inventory[MEM_POOL_INVENTORY_LEN];
+
+static void
+mem_pool_account(mem_pool_header_t *header) {
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+
+    mem_pool_stats_t *stats = &mem_pool_stats[header->class];
+    stats->current++;
+    stats->peak = MAX(stats->peak, stats->current);
+
+    header->deployment = mem_pool_deployment;
+    if (mem_pool_deployment) {
+        mem_pool_deployment_current++;
+        mem_pool_deployment_peak = MAX(mem_pool_deployment_peak, mem_pool_deployment_current);
+    }
+
+    k_spin_unlock(&mem_pool_lock, key);
+}
+
+static void
+mem_pool_fail(mem_pool_class_t pool_class) {
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+    mem_pool_stats[pool_class].failures++;
+    k_spin_unlock(&mem_pool_lock, key);
+}
+
+static void *
+mem_pool_malloc(size_t size) {
+    mem_pool_header_t *header = NULL;
+    int                class;
+
+    if (size > UINT32_MAX - MEM_POOL_HEADER_SIZE) {
+        return NULL;
+    }
+
+    for (class = 0; class < MEM_POOL_CLASS_HEAP; class++) {
+        if (size + MEM_POOL_HEADER_SIZE > mem_pool_block_sizes[class]) {
+            continue;
+        }
+        if (0 == k_mem_slab_alloc(mem_pool_slabs[class], (void **)&header, K_NO_WAIT)) {
+            break;
+        }
+        mem_pool_fail(class);
+    }
+
+    if ((MEM_POOL_CLASS_HEAP == class) && (NULL == (header = malloc(size + MEM_POOL_HEADER_SIZE)))) {
+        mem_pool_fail(MEM_POOL_CLASS_HEAP);
+        return NULL;
+    }
+
+    header->size  = size;
+    header->class = class;
+    mem_pool_account(header);
+
+    return (uint8_t *)header + MEM_POOL_HEADER_SIZE;
+}
+
+static void
+mem_pool_free(void *ptr) {
+    if (NULL == ptr) {
+        return;
+    }
+
+    mem_pool_header_t *header = (mem_pool_header_t *)((uint8_t *)ptr - MEM_POOL_HEADER_SIZE);
+    assert(header->class < MEM_POOL_CLASS_COUNT);
+
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+    mem_pool_stats[header->class].current--;
+    if (header->deployment && (mem_pool_deployment_current > 0)) {
+        mem_pool_deployment_current--;
+    }
+    k_spin_unlock(&mem_pool_lock, key);
+
+    if (MEM_POOL_CLASS_HEAP == header->class) {
+        free(header);
+    } else {
+        k_mem_slab_free(mem_pool_slabs[header->class], header);
+    }
+}
+
+static void *
+mem_pool_realloc(void *ptr, size_t size) {
+    if (NULL == ptr) {
+        return mem_pool_malloc(size);
+    }
+
+    mem_pool_header_t *header = (mem_pool_header_t *)((uint8_t *)ptr - MEM_POOL_HEADER_SIZE);
+
+    /* Still fits in its block */
+    if ((MEM_POOL_CLASS_HEAP != header->class) && (size + MEM_POOL_HEADER_SIZE <= mem_pool_block_sizes[header->class])) {
+        header->size = size;
+        return ptr;
+    }
+
+    /* Still too big for the pools, the heap can grow it in place */
+    if ((MEM_POOL_CLASS_HEAP == header->class) && (size + MEM_POOL_HEADER_SIZE > mem_pool_block_sizes[MEM_POOL_CLASS_HEAP - 1])) {
+        if (size > UINT32_MAX - MEM_POOL_HEADER_SIZE) {
+            return NULL;
+        }
+        mem_pool_header_t *new_header = realloc(header, size + MEM_POOL_HEADER_SIZE);
+        if (NULL == new_header) {
+            mem_pool_fail(MEM_POOL_CLASS_HEAP);
+            return NULL;
+        }
+        new_header->size = size;
+        return (uint8_t *)new_header + MEM_POOL_HEADER_SIZE;
+    }
+
+    void *new_ptr = mem_pool_malloc(size);
+    if (NULL == new_ptr) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, MIN(size, header->size));
+    mem_pool_free(ptr);
+
+    return new_ptr;
+}
+
+mender_err_t
+mem_pool_init(void) {
+    return mender_set_allocation_funcs(mem_pool_malloc, mem_pool_realloc, mem_pool_free);
+}
+
+void
+mem_pool_deployment_begin(void) {
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+    if (!mem_pool_deployment) {
+        mem_pool_deployment         = true;
+        mem_pool_deployment_current = 0;
+        mem_pool_deployment_peak    = 0;
+    }
+    k_spin_unlock(&mem_pool_lock, key);
+}
+
+void
+mem_pool_deployment_end(void) {
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+    bool             was_running = mem_pool_deployment;
+    uint32_t         current     = mem_pool_deployment_current;
+    uint32_t         peak        = mem_pool_deployment_peak;
+    mem_pool_deployment          = false;
+    k_spin_unlock(&mem_pool_lock, key);
+
+    if (was_running) {
+        LOG_INF("Deployment allocations: peak %u, %u still in use", peak, current);
+    }
+}
+
+void
+mem_pool_get_stats(mem_pool_class_t pool_class, mem_pool_stats_t *stats) {
+    assert(pool_class < MEM_POOL_CLASS_COUNT);
+    assert(NULL != stats);
+
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+    *stats               = mem_pool_stats[pool_class];
+    k_spin_unlock(&mem_pool_lock, key);
+}
+
+static mender_err_t
+mem_pool_inventory_cb(mender_keystore_t **keystore, uint8_t *keystore_len) {
+    mem_pool_stats_t stats;
+
+    for (int i = 0; i < MEM_POOL_CLASS_COUNT; i++) {
+        mem_pool_get_stats(i, &stats);
+        snprintf(mem_pool_inventory_values[i], sizeof(mem_pool_inventory_values[i]), "%u/%u/%u", stats.current, stats.peak, stats.failures);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&mem_pool_lock);
+    uint32_t         current = mem_pool_deployment_current;
+    uint32_t         peak    = mem_pool_deployment_peak;
+    k_spin_unlock(&mem_pool_lock, key);
+    snprintf(mem_pool_inventory_values[MEM_POOL_CLASS_COUNT], sizeof(mem_pool_inventory_values[0]), "%u/%u", current, peak);
+
+    *keystore     = mem_pool_inventory;
+    *keystore_len = MEM_POOL_INVENTORY_LEN;
+
+    return MENDER_OK;
+}
+
+mender_err_t
+mem_pool_add_inventory(void) {
+    for (int i = 0; i < MEM_POOL_INVENTORY_LEN; i++) {
+        mem_pool_inventory[i].name  = (MEM_POOL_CLASS_COUNT == i) ? "mem_deployment" : (char *)mem_pool_names[i];
+        mem_pool_inventory[i].value = mem_pool_inventory_values[i];
+    }
+
+    /* Persistent: the keystore is static, the client must not free it; the counters are updated
+       in place */
+    return mender_inventory_add_callback(mem_pool_inventory_cb, true);
+}
@@ -0,0 +1,80 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __MEM_POOL_H__
+#define __MEM_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Allocation classes: one per pool block size, then the heap for what does not fit
+ */
+typedef enum {
+    MEM_POOL_CLASS_32 = 0,
+    MEM_POOL_CLASS_64,
+    MEM_POOL_CLASS_128,
+    MEM_POOL_CLASS_256,
+    MEM_POOL_CLASS_512,
+    MEM_POOL_CLASS_HEAP,
+    MEM_POOL_CLASS_COUNT,
+} mem_pool_class_t;
+
+/**
+ * @brief Counters of an allocation class
+ */
+typedef struct {
+    uint32_t current;  /**< Allocations in use */
+    uint32_t peak;     /**< Highest number of allocations in use */
+    uint32_t failures; /**< Allocations which did not fit; for a pool, they went to a bigger class */
+} mem_pool_stats_t;
+
+/**
+ * @brief Make the Mender client allocate from the pools
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note Must be called before mender_client_init()
+ */
+mender_err_t mem_pool_init(void);
+
+/**
+ * @brief Start counting the allocations made for a deployment
+ */
+void mem_pool_deployment_begin(void);
+
+/**
+ * @brief Stop counting the allocations made for a deployment, logging the ones still in use
+ */
+void mem_pool_deployment_end(void);
+
+/**
+ * @brief Get the counters of an allocation class
+ */
+void mem_pool_get_stats(mem_pool_class_t pool_class, mem_pool_stats_t *stats);
+
+/**
+ * @brief Publish the counters in the inventory, as "current/peak/failures" per class
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ */
+mender_err_t mem_pool_add_inventory(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __MEM_POOL_H__ */
@@ -19,27 +19,142 @@ LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
  * https://github.com/zephyrproject-rtos/zephyr/tree/v3.7.0/samples/net/dhcpv4_client
  * https://github.com/zephyrproject-rtos/zephyr/tree/v3.7.0/samples/net/cloud/tagoio_http_post
  *
- * The main entry point, netup_wait_for_network, will set up the callbacks for the network
- * management and wait for NET_EVENT_IPV4_ADDR_ADD event (iow, the device obtained an IP address.
- * If WIFI configuration is enabled, a CONNECT request is issued and it is assumed that obtaining
- * the IP address is managed somewhere else.
- * The wait from netup_wait_for_network for the described event is controlled with a semaphore. */
+ * The main entry point, netup_start, will set up the callbacks for the network management and
+ * return right away; the NET_EVENT_IPV4_ADDR_ADD event (iow, the device obtained an IP address)
+ * is reported through the ready callback, so that the application can initialize in the meantime.
+ * If WIFI configuration is enabled, a CONNECT request is issued from the system work queue and it
+ * is assumed that obtaining the IP address is managed somewhere else.
+ * netup_wait_for_network waits for the described event with a semaphore.
+ *
+ * With MENDER_APP_NET_LEASE_CACHE, the last lease is kept in the settings: on startup its address
+ * is set as a static one and the network is reported up immediately. The DHCP client of Zephyr
+ * has no way to request a known address first, it runs a full exchange behind the cached address
+ * and replaces it once bound. */
 
 #include "netup.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
+#include <errno.h>
+
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/net/net_if.h>
 #include <zephyr/net/net_mgmt.h>
 #if defined(CONFIG_WIFI)
 #include <zephyr/net/wifi_mgmt.h>
 #endif
 
+#ifdef CONFIG_MENDER_APP_NET_LEASE_CACHE
+#include "persist.h"
+#endif /* CONFIG_MENDER_APP_NET_LEASE_CACHE */
+
 static K_SEM_DEFINE(network_ready_sem, 0, 1);
 
 static struct net_mgmt_event_callback mgmt_cb;
+static netup_ready_cb_t               network_ready_cb;
+static bool                           network_started;
+static atomic_t                       network_up = ATOMIC_INIT(0);
+
+#ifdef CONFIG_MENDER_APP_NETWORK_ON_DEMAND
+/* A renewed lease does not always add the address again, the DHCP bound event tells it is usable */
+#define NETWORK_EVENTS (NET_EVENT_IPV4_ADDR_ADD | NET_EVENT_IPV4_DHCP_BOUND)
+
+/* Radio-on (interface up) time counters, logged when the interface goes down */
+typedef struct {
+    uint32_t cycles;          /* Number of up/down cycles */
+    uint32_t last_on_ms;      /* Time the interface was up in the last cycle */
+    uint32_t last_connect_ms; /* Time to get an address in the last cycle */
+    uint64_t total_on_ms;     /* Time the interface was up over all the cycles */
+} netup_stats_t;
+
+static K_MUTEX_DEFINE(network_lock);
+
+static unsigned int  network_users;
+static int64_t       network_on_ms;
+static netup_stats_t network_stats;
+#else
+#define NETWORK_EVENTS NET_EVENT_IPV4_ADDR_ADD
+#endif /* CONFIG_MENDER_APP_NETWORK_ON_DEMAND */
+
+#ifdef CONFIG_MENDER_APP_NET_LEASE_CACHE
+
+#define NETUP_LEASE_KEY "net/lease"
+
+typedef struct {
+    struct in_addr address;
+    struct in_addr netmask;
+    struct in_addr router;
+    struct in_addr server;
+    uint32_t       lease_time;
+} netup_lease_t;
+
+/* Last lease saved, to avoid writing the flash on every renewal */
+static netup_lease_t network_lease;
+static bool          network_lease_valid;
+
+static void
+lease_load(struct net_if *iface) {
+    char buf[NET_IPV4_ADDR_LEN];
+    int  ret;
+
+    if (sizeof(network_lease) != (ret = persist_load(NETUP_LEASE_KEY, &network_lease, sizeof(network_lease)))) {
+        if (-ENOENT != ret) {
+            LOG_WRN("Unable to load the cached DHCP lease: %d", ret);
+        }
+        return;
+    }
+    network_lease_valid = true;
+
+    if (NULL == net_if_ipv4_addr_add(iface, &network_lease.address, NET_ADDR_OVERRIDABLE, 0)) {
+        LOG_WRN("Unable to set the cached address");
+        return;
+    }
+    net_if_ipv4_set_netmask_by_addr(iface, &network_lease.address, &network_lease.netmask);
+    net_if_ipv4_set_gw(iface, &network_lease.router);
+    LOG_INF("Using cached address %s until DHCP completes", net_addr_ntop(AF_INET, &network_lease.address, buf, sizeof(buf)));
+
+    atomic_set(&network_up, 1);
+    k_sem_give(&network_ready_sem);
+    if (NULL != network_ready_cb) {
+        network_ready_cb();
+    }
+}
+
+static void
+lease_save(struct net_if *iface) {
+    netup_lease_t lease = { 0 };
+    char          buf[NET_IPV4_ADDR_LEN];
+    int           ret;
+
+    lease.address    = iface->config.dhcpv4.requested_ip;
+    lease.netmask    = net_if_ipv4_get_netmask_by_addr(iface, &lease.address);
+    lease.router     = iface->config.ip.ipv4->gw;
+    lease.server     = iface->config.dhcpv4.server_id;
+    lease.lease_time = iface->config.dhcpv4.lease_time;
+
+    LOG_INF("DHCP bound to %s", net_addr_ntop(AF_INET, &lease.address, buf, sizeof(buf)));
+
+    /* A different address was leased, the cached one must not linger */
+    if (network_lease_valid && !net_ipv4_addr_cmp(&lease.address, &network_lease.address)) {
+        net_if_ipv4_addr_rm(iface, &network_lease.address);
+    }
+
+    if (network_lease_valid && (0 == memcmp(&lease, &network_lease, sizeof(lease)))) {
+        return;
+    }
+    if (0 != (ret = persist_save(NETUP_LEASE_KEY, &lease, sizeof(lease)))) {
+        LOG_WRN("Unable to save the DHCP lease: %d", ret);
+        return;
+    }
+    network_lease       = lease;
+    network_lease_valid = true;
+    LOG_INF("Saved DHCP lease");
+}
+
+#endif /* CONFIG_MENDER_APP_NET_LEASE_CACHE */
 
 #if defined(CONFIG_WIFI)
 
@@ -71,17 +186,33 @@ wifi_connect(struct net_if *iface) {
     }
 }
 
+static void
+wifi_connect_work_handler(struct k_work *work) {
+    ARG_UNUSED(work);
+
+    wifi_connect(net_if_get_default());
+}
+
+static K_WORK_DEFINE(wifi_connect_work, wifi_connect_work_handler);
+
 #endif
 
 static void
 event_handler(struct net_mgmt_event_callback *cb, uint64_t mgmt_event, struct net_if *iface) {
     int i = 0;
 
-    if (mgmt_event != NET_EVENT_IPV4_ADDR_ADD) {
+#ifdef CONFIG_MENDER_APP_NET_LEASE_CACHE
+    if (mgmt_event == NET_EVENT_IPV4_DHCP_BOUND) {
+        lease_save(iface);
+    }
+#endif /* CONFIG_MENDER_APP_NET_LEASE_CACHE */
+
+    if ((mgmt_event != NET_EVENT_IPV4_ADDR_ADD) && ((mgmt_event != NET_EVENT_IPV4_DHCP_BOUND) || !IS_ENABLED(CONFIG_MENDER_APP_NETWORK_ON_DEMAND))) {
         return;
     }
 
-    for (i = 0; i < NET_IF_MAX_IPV4_ADDR; i++) {
+    /* Only log the lease when the address is added */
+    for (i = 0; (NET_EVENT_IPV4_ADDR_ADD == mgmt_event) && (i < NET_IF_MAX_IPV4_ADDR); i++) {
         char buf[NET_IPV4_ADDR_LEN];
 
         if (iface->config.ip.ipv4->unicast[i].ipv4.addr_type != NET_ADDR_DHCP) {
@@ -97,12 +228,21 @@ event_handler(struct net_mgmt_event_callback *cb, uint64_t mgmt_event, struct ne
     }
 
     // Network is up \o/
+    atomic_set(&network_up, 1);
     k_sem_give(&network_ready_sem);
+    if (NULL != network_ready_cb) {
+        network_ready_cb();
+    }
 }
 
 int
-netup_wait_for_network(void) {
-    net_mgmt_init_event_callback(&mgmt_cb, event_handler, NET_EVENT_IPV4_ADDR_ADD);
+netup_start(netup_ready_cb_t ready_cb) {
+    assert(!network_started);
+    network_started  = true;
+    network_ready_cb = ready_cb;
+
+    /* The lease is saved once DHCP is bound, whether or not that event brings the network up */
+    net_mgmt_init_event_callback(&mgmt_cb, event_handler, NETWORK_EVENTS | (IS_ENABLED(CONFIG_MENDER_APP_NET_LEASE_CACHE) ? NET_EVENT_IPV4_DHCP_BOUND : 0));
     net_mgmt_add_event_callback(&mgmt_cb);
 
     /* Assume that there is only one network interface, having two or more will just pick up
@@ -110,24 +250,112 @@ netup_wait_for_network(void) {
     struct net_if *iface = net_if_get_default();
     LOG_INF("Using net interface %s, index=%d", net_if_get_device(iface)->name, net_if_get_by_iface(iface));
 
+#ifdef CONFIG_MENDER_APP_NET_LEASE_CACHE
+    lease_load(iface);
+#endif /* CONFIG_MENDER_APP_NET_LEASE_CACHE */
+
 #if defined(CONFIG_WIFI)
-    wifi_connect(iface);
+    k_work_submit(&wifi_connect_work);
 #else
     /* For WIFI, it is expected that the dhcp client is started somehow by the network management.
     This is the case for example for ESP32-S3 with configuration option WIFI_STA_AUTO_DHCPV4 */
     net_dhcpv4_start(iface);
 #endif
 
+    LOG_INF("Bringing network up...");
+    return 0;
+}
+
+int
+netup_wait_for_network(void) {
+    int ret;
+
+    if (!network_started && (0 != (ret = netup_start(NULL)))) {
+        return ret;
+    }
+
     // Wait for network
     LOG_INF("Waiting for network up...");
-    return k_sem_take(&network_ready_sem, K_FOREVER);
+    ret = k_sem_take(&network_ready_sem, K_FOREVER);
+    k_sem_give(&network_ready_sem);
+    return ret;
+}
+
+#ifdef CONFIG_MENDER_APP_NETWORK_ON_DEMAND
+
+static void
+network_down(struct net_if *iface) {
+#if defined(CONFIG_WIFI)
+    net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0);
+#endif
+    net_if_down(iface);
+    atomic_set(&network_up, 0);
+}
+
+int
+netup_connect(void) {
+    struct net_if *iface = net_if_get_default();
+    int            ret   = 0;
+
+    k_mutex_lock(&network_lock, K_FOREVER);
+
+    if (0 == network_users++) {
+        network_on_ms = k_uptime_get();
+
+        if (!atomic_get(&network_up)) {
+            LOG_INF("Bringing network up on demand...");
+            k_sem_reset(&network_ready_sem);
+            net_if_up(iface);
+#if defined(CONFIG_WIFI)
+            wifi_connect(iface);
+#endif
+            /* DHCP restarts by itself when the interface comes back up */
+            if (0 != (ret = k_sem_take(&network_ready_sem, K_SECONDS(CONFIG_MENDER_APP_NETWORK_ON_DEMAND_TIMEOUT)))) {
+                LOG_ERR("Network not up after %d seconds", CONFIG_MENDER_APP_NETWORK_ON_DEMAND_TIMEOUT);
+                /* Nobody is left to release it, do not keep the radio on */
+                network_down(iface);
+                network_users--;
+                ret = -ETIMEDOUT;
+            }
+        }
+        network_stats.last_connect_ms = (uint32_t)(k_uptime_get() - network_on_ms);
+    }
+
+    k_mutex_unlock(&network_lock);
+
+    return ret;
 }
 
+void
+netup_release(void) {
+    struct net_if *iface = net_if_get_default();
+
+    k_mutex_lock(&network_lock, K_FOREVER);
+
+    assert(network_users > 0);
+    if (0 == --network_users) {
+        network_down(iface);
+
+        network_stats.last_on_ms = (uint32_t)(k_uptime_get() - network_on_ms);
+        network_stats.total_on_ms += network_stats.last_on_ms;
+        network_stats.cycles++;
+        LOG_INF("Network down: on for %u ms (up in %u ms), %llu ms over %u cycles",
+                network_stats.last_on_ms,
+                network_stats.last_connect_ms,
+                (unsigned long long)network_stats.total_on_ms,
+                network_stats.cycles);
+    }
+
+    k_mutex_unlock(&network_lock);
+}
+
+#endif /* CONFIG_MENDER_APP_NETWORK_ON_DEMAND */
+
 void
 netup_get_mac_address(char *address) {
     assert(NULL != address);
 
-    struct net_if *iface = net_if_get_first_up();
+    struct net_if *iface = net_if_get_default();
     assert(NULL != iface);
 
     struct net_linkaddr *linkaddr = net_if_get_link_addr(iface);
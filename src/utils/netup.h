@@ -19,14 +19,51 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stdint.h>
+
+/**
+ * @brief Called once the network is up
+ * @note Runs in the network management thread, must not block
+ */
+typedef void (*netup_ready_cb_t)(void);
+
+/**
+ * @brief Start bringing the network up without waiting for it
+ * @param ready_cb Called when an IP address has been leased by the DHCP server, or right away
+ *                 with MENDER_APP_NET_LEASE_CACHE if a lease is cached; may be NULL
+ * @return return 0 on success, -errno on error
+ * @note The Wi-Fi association, if any, is done from the system work queue
+ */
+int netup_start(netup_ready_cb_t ready_cb);
+
 /**
  * @brief Wait for an IP address to be leased by the DHCP server
  * @return return 0 on success, -errno on error
+ * @note Starts the network if netup_start() has not been called
  */
 int netup_wait_for_network();
 
+#ifdef CONFIG_MENDER_APP_NETWORK_ON_DEMAND
+
+/**
+ * @brief Take a reference on the network, bringing the interface up if needed
+ * @return return 0 on success, -ETIMEDOUT if no address was leased within
+ *         CONFIG_MENDER_APP_NETWORK_ON_DEMAND_TIMEOUT seconds
+ * @note Blocks until the network is usable; the first successful call after netup_start() does
+ *       not need to wait if the network is already up
+ */
+int netup_connect(void);
+
+/**
+ * @brief Drop a reference on the network, taking the interface down with the last one
+ */
+void netup_release(void);
+
+#endif /* CONFIG_MENDER_APP_NETWORK_ON_DEMAND */
+
 /**
  * @brief Get MAC address
+ * @note Available as soon as the interface is initialized, before the network is up
  */
 void netup_get_mac_address(char *address);
 
@@ -0,0 +1,131 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+#include "persist.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/settings/settings.h>
+
+/* The settings default to storage_partition, which the Mender client formats for itself */
+#ifdef CONFIG_MENDER_STORAGE_PARTITION_STORAGE_PARTITION
+#if !DT_HAS_CHOSEN(zephyr_settings_partition)
+#error "The Mender client uses storage_partition, choose another zephyr,settings-partition in the board overlay"
+#elif DT_SAME_NODE(DT_CHOSEN(zephyr_settings_partition), DT_NODELABEL(storage_partition))
+#error "zephyr,settings-partition must not be storage_partition, the Mender client uses it"
+#endif
+#endif /* CONFIG_MENDER_STORAGE_PARTITION_STORAGE_PARTITION */
+
+#define PERSIST_PREFIX  "app/"
+#define PERSIST_KEY_MAX (SETTINGS_MAX_NAME_LEN + 1)
+
+typedef struct {
+    void  *data;
+    size_t len;
+    int    ret;
+} persist_load_ctx_t;
+
+static K_MUTEX_DEFINE(persist_lock);
+static bool persist_initialized;
+
+static int
+persist_init(void) {
+    int ret = 0;
+
+    /* Callers come from several threads, the first one initializes the settings */
+    k_mutex_lock(&persist_lock, K_FOREVER);
+    if (!persist_initialized) {
+        if (0 != (ret = settings_subsys_init())) {
+            LOG_ERR("Unable to initialize the settings: %d", ret);
+        } else {
+            persist_initialized = true;
+        }
+    }
+    k_mutex_unlock(&persist_lock);
+
+    return ret;
+}
+
+static int
+persist_key(char *buf, size_t size, const char *key) {
+    assert(NULL != key);
+
+    int len = snprintf(buf, size, PERSIST_PREFIX "%s", key);
+    return ((len < 0) || ((size_t)len >= size)) ? -ENAMETOOLONG : 0;
+}
+
+static int
+persist_load_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param) {
+    persist_load_ctx_t *ctx = param;
+
+    /* Only the exact key, not the ones below it */
+    if (NULL != key) {
+        return 0;
+    }
+    if (len > ctx->len) {
+        ctx->ret = -EMSGSIZE;
+        return 1;
+    }
+    ssize_t ret = read_cb(cb_arg, ctx->data, len);
+    ctx->ret    = (ret < 0) ? (int)ret : (int)len;
+
+    return 1;
+}
+
+int
+persist_load(const char *key, void *data, size_t len) {
+    char               name[PERSIST_KEY_MAX];
+    persist_load_ctx_t ctx = { .data = data, .len = len, .ret = -ENOENT };
+    int                ret;
+
+    if ((0 != (ret = persist_init())) || (0 != (ret = persist_key(name, sizeof(name), key)))) {
+        return ret;
+    }
+    if (0 != (ret = settings_load_subtree_direct(name, persist_load_cb, &ctx))) {
+        return ret;
+    }
+
+    return ctx.ret;
+}
+
+int
+persist_save(const char *key, const void *data, size_t len) {
+    char name[PERSIST_KEY_MAX];
+    int  ret;
+
+    if ((0 != (ret = persist_init())) || (0 != (ret = persist_key(name, sizeof(name), key)))) {
+        return ret;
+    }
+
+    return settings_save_one(name, data, len);
+}
+
+int
+persist_delete(const char *key) {
+    char name[PERSIST_KEY_MAX];
+    int  ret;
+
+    if ((0 != (ret = persist_init())) || (0 != (ret = persist_key(name, sizeof(name), key)))) {
+        return ret;
+    }
+
+    return settings_delete(name);
+}
@@ -0,0 +1,55 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __PERSIST_H__
+#define __PERSIST_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+
+/* Small key/value store for the application state that has to survive a reboot, on top of the
+ * Zephyr settings subsystem. Values are stored under "app/<key>", in the partition chosen as
+ * zephyr,settings-partition in the devicetree (storage_partition otherwise), which must not be the
+ * one used by the Mender client. */
+
+/**
+ * @brief Read a value
+ * @param key Name of the value
+ * @param data Buffer for the value
+ * @param len Size of the buffer
+ * @return Size of the value on success, -ENOENT if it does not exist, -EMSGSIZE if it does not
+ *         fit into the buffer, -errno on other errors
+ */
+int persist_load(const char *key, void *data, size_t len);
+
+/**
+ * @brief Write a value
+ * @return 0 on success, -errno on error
+ */
+int persist_save(const char *key, const void *data, size_t len);
+
+/**
+ * @brief Delete a value
+ * @return 0 on success (including if it did not exist), -errno on error
+ */
+int persist_delete(const char *key);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __PERSIST_H__ */
@@ -0,0 +1,176 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The client polls for deployments every CONFIG_MENDER_CLIENT_UPDATE_POLL_INTERVAL seconds, so
+ * devices started together poll together for as long as they run. The polls are triggered from
+ * here instead, with mender_client_execute(), which also restarts the period of the client: with
+ * CONFIG_MENDER_CLIENT_UPDATE_POLL_INTERVAL above CONFIG_MENDER_APP_POLL_SCHED_MAX_INTERVAL, the
+ * client only polls by itself if a trigger is missed.
+ *
+ * - Every device waits a fixed fraction of CONFIG_MENDER_APP_POLL_SCHED_STARTUP_SPREAD before
+ *   activating the client, and lengthens all its intervals by a fixed percentage of up to
+ *   CONFIG_MENDER_APP_POLL_SCHED_JITTER, both derived from its identity. Devices started
+ *   together spread out, and their polls drift further apart over time.
+ * - A poll returning a deployment shortens the interval to CONFIG_MENDER_APP_POLL_SCHED_MIN_INTERVAL
+ *   for CONFIG_MENDER_APP_POLL_SCHED_TIGHT_WINDOW seconds. Afterwards every poll without a
+ *   deployment doubles it, from CONFIG_MENDER_APP_POLL_SCHED_INTERVAL up to
+ *   CONFIG_MENDER_APP_POLL_SCHED_MAX_INTERVAL.
+ * - A 429 or 503 response to any request of the client postpones the next poll by its
+ *   Retry-After header, or by an exponential backoff if it has none.
+ *
+ * The responses are seen through the HTTP observer, the client does not report them. */
+
+#include "poll-sched.h"
+#include "http-observer.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+
+#include <mender/client.h>
+
+#define FNV1A_OFFSET 0x811c9dc5u
+#define FNV1A_PRIME  0x01000193u
+
+static uint32_t poll_sched_jitter;      /* Percent */
+static uint32_t poll_sched_startup;     /* Seconds */
+static uint32_t poll_sched_interval;    /* Seconds, before the jitter */
+static uint32_t poll_sched_backoff;     /* Seconds, 0 if the server is not busy */
+static int64_t  poll_sched_tight_until; /* Uptime in ms */
+static bool     poll_sched_started;
+
+static K_MUTEX_DEFINE(poll_sched_lock);
+
+static void poll_sched_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(poll_sched_work, poll_sched_work_handler);
+
+static uint32_t
+fnv1a(uint32_t hash, const char *data) {
+    for (; '\0' != *data; data++) {
+        hash = (hash ^ (uint8_t)*data) * FNV1A_PRIME;
+    }
+
+    return hash;
+}
+
+/* Reschedules the next poll, must be called with the lock held */
+static void
+poll_sched_reschedule(uint32_t seconds) {
+    seconds += seconds * poll_sched_jitter / 100;
+
+    if (poll_sched_started) {
+        k_work_reschedule(&poll_sched_work, K_SECONDS(seconds));
+    }
+    LOG_DBG("Next poll in %u s", seconds);
+}
+
+static void
+poll_sched_work_handler(struct k_work *work) {
+    ARG_UNUSED(work);
+
+    if (MENDER_OK != mender_client_execute()) {
+        LOG_WRN("Unable to trigger the deployment poll");
+    }
+
+    /* Rescheduled again once the poll is done, this is in case it does not happen */
+    k_mutex_lock(&poll_sched_lock, K_FOREVER);
+    poll_sched_reschedule(MAX(poll_sched_interval, poll_sched_backoff));
+    k_mutex_unlock(&poll_sched_lock);
+}
+
+/* Updates the intervals from the response to a request, must be called with the lock held */
+static void
+poll_sched_update(const char *url, uint16_t status, uint32_t retry_after) {
+    bool poll = (NULL != url) && (NULL != strstr(url, "/deployments/next"));
+
+    if ((429 == status) || (503 == status)) {
+        if (0 != retry_after) {
+            poll_sched_backoff = MIN(retry_after, CONFIG_MENDER_APP_POLL_SCHED_MAX_INTERVAL);
+        } else {
+            poll_sched_backoff = MIN(MAX(2 * poll_sched_backoff, CONFIG_MENDER_APP_POLL_SCHED_MIN_INTERVAL),
+                                     CONFIG_MENDER_APP_POLL_SCHED_MAX_INTERVAL);
+        }
+        LOG_WRN("Server busy (%u), backing off for %u s", status, poll_sched_backoff);
+        poll_sched_reschedule(MAX(poll_sched_interval, poll_sched_backoff));
+        return;
+    }
+    if (!poll) {
+        return;
+    }
+
+    poll_sched_backoff = 0;
+    if (200 == status) {
+        /* Follow-up deployments of a rollout are picked up early */
+        poll_sched_interval    = CONFIG_MENDER_APP_POLL_SCHED_MIN_INTERVAL;
+        poll_sched_tight_until = k_uptime_get() + CONFIG_MENDER_APP_POLL_SCHED_TIGHT_WINDOW * MSEC_PER_SEC;
+    } else if (k_uptime_get() >= poll_sched_tight_until) {
+        if (poll_sched_interval < CONFIG_MENDER_APP_POLL_SCHED_INTERVAL) {
+            poll_sched_interval = CONFIG_MENDER_APP_POLL_SCHED_INTERVAL;
+        } else {
+            poll_sched_interval = MIN(2 * poll_sched_interval, CONFIG_MENDER_APP_POLL_SCHED_MAX_INTERVAL);
+        }
+    }
+    poll_sched_reschedule(poll_sched_interval);
+}
+
+static void
+poll_sched_http_cb(const struct http_request *req, uint16_t status, uint32_t retry_after) {
+    k_mutex_lock(&poll_sched_lock, K_FOREVER);
+    poll_sched_update(req->url, status, retry_after);
+    k_mutex_unlock(&poll_sched_lock);
+}
+
+mender_err_t
+poll_sched_init(const mender_identity_t *identity) {
+    assert(NULL != identity);
+    assert((NULL != identity->name) && (NULL != identity->value));
+
+    uint32_t     hash = fnv1a(fnv1a(FNV1A_OFFSET, identity->name), identity->value);
+    mender_err_t ret;
+
+    /* Before the activation, to see the responses to the first requests already */
+    if (MENDER_OK != (ret = http_observer_add(poll_sched_http_cb))) {
+        return ret;
+    }
+
+    k_mutex_lock(&poll_sched_lock, K_FOREVER);
+    poll_sched_jitter   = (hash & 0xffff) % (CONFIG_MENDER_APP_POLL_SCHED_JITTER + 1);
+    poll_sched_startup  = (hash >> 16) % (CONFIG_MENDER_APP_POLL_SCHED_STARTUP_SPREAD + 1);
+    poll_sched_interval = CONFIG_MENDER_APP_POLL_SCHED_INTERVAL;
+    k_mutex_unlock(&poll_sched_lock);
+
+    LOG_INF("Poll jitter: +%u%%, startup delay %u s", poll_sched_jitter, poll_sched_startup);
+
+    return MENDER_OK;
+}
+
+uint32_t
+poll_sched_startup_delay(void) {
+    return poll_sched_startup;
+}
+
+mender_err_t
+poll_sched_start(void) {
+    k_mutex_lock(&poll_sched_lock, K_FOREVER);
+    poll_sched_started = true;
+    poll_sched_reschedule(poll_sched_interval);
+    k_mutex_unlock(&poll_sched_lock);
+
+    return MENDER_OK;
+}
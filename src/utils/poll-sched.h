@@ -0,0 +1,52 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __POLL_SCHED_H__
+#define __POLL_SCHED_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <mender/client.h>
+
+/**
+ * @brief Derive the jitter of the device from its identity
+ * @param identity Identity of the device, as given to the client
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note Must be called before poll_sched_startup_delay() and poll_sched_start()
+ */
+mender_err_t poll_sched_init(const mender_identity_t *identity);
+
+/**
+ * @brief Get the time to wait before activating the client
+ * @return Seconds, up to CONFIG_MENDER_APP_POLL_SCHED_STARTUP_SPREAD, the same on every boot of
+ *         the device
+ */
+uint32_t poll_sched_startup_delay(void);
+
+/**
+ * @brief Start triggering the deployment polls
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note To be called once the client is activated
+ */
+mender_err_t poll_sched_start(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __POLL_SCHED_H__ */
@@ -0,0 +1,177 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* A phase lasts from the end of the last of the phases it waits for (reset for the first one) to
+ * its mark. The network comes up while the client is initialized, the client is activated once
+ * both are done. The client has no hook for authentication or polling, so these two are
+ * approximated: the inventory is only requested from an authenticated client, and the first
+ * network release after that ends the first round of requests to the server. */
+
+#include "profiler.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include <mender/inventory.h>
+
+static const char *profiler_names[PROFILER_PHASE_COUNT] = {
+    [PROFILER_PHASE_KERNEL]        = "kernel",
+    [PROFILER_PHASE_NETWORK]       = "network",
+    [PROFILER_PHASE_CERTS]         = "certs",
+    [PROFILER_PHASE_CLIENT_INIT]   = "client_init",
+    [PROFILER_PHASE_MODULES]       = "modules",
+    [PROFILER_PHASE_ACTIVATE]      = "activate",
+    [PROFILER_PHASE_AUTHENTICATED] = "authenticated",
+    [PROFILER_PHASE_FIRST_POLL]    = "first_poll",
+};
+
+/* Phases which must be done before each phase starts */
+static const uint32_t profiler_deps[PROFILER_PHASE_COUNT] = {
+    [PROFILER_PHASE_KERNEL]        = 0,
+    [PROFILER_PHASE_NETWORK]       = BIT(PROFILER_PHASE_KERNEL),
+    [PROFILER_PHASE_CERTS]         = BIT(PROFILER_PHASE_KERNEL),
+    [PROFILER_PHASE_CLIENT_INIT]   = BIT(PROFILER_PHASE_CERTS),
+    [PROFILER_PHASE_MODULES]       = BIT(PROFILER_PHASE_CLIENT_INIT),
+    [PROFILER_PHASE_ACTIVATE]      = BIT(PROFILER_PHASE_NETWORK) | BIT(PROFILER_PHASE_MODULES),
+    [PROFILER_PHASE_AUTHENTICATED] = BIT(PROFILER_PHASE_ACTIVATE),
+    [PROFILER_PHASE_FIRST_POLL]    = BIT(PROFILER_PHASE_AUTHENTICATED),
+};
+
+/* End of each phase, in microseconds since reset */
+static uint64_t profiler_marks[PROFILER_PHASE_COUNT];
+/* Phases done; a bit is only set once the mark is stored */
+static atomic_t profiler_done = ATOMIC_INIT(0);
+/* Phases being marked, to keep the first mark only */
+static atomic_t profiler_claimed = ATOMIC_INIT(0);
+
+/* One inventory entry per phase, plus the total */
+#define PROFILER_INVENTORY_LEN (PROFILER_PHASE_COUNT + 1)
+static char              profiler_inventory_names[PROFILER_INVENTORY_LEN][24];
+static char              profiler_inventory_values[PROFILER_INVENTORY_LEN][11];
+static mender_keystore_t profiler_inventory[PROFILER_INVENTORY_LEN];
+
+static uint64_t
+profiler_now_us(void) {
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+#endif /* CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER */
+}
+
+static bool
+profiler_is_done(uint32_t phases) {
+    return phases == ((uint32_t)atomic_get(&profiler_done) & phases);
+}
+
+/* Start of a phase: the end of the last phase it waits for */
+static uint64_t
+profiler_start_us(profiler_phase_t phase) {
+    uint64_t start = 0;
+
+    for (int i = 0; i < PROFILER_PHASE_COUNT; i++) {
+        if (0 != (profiler_deps[phase] & BIT(i))) {
+            start = MAX(start, profiler_marks[i]);
+        }
+    }
+    return start;
+}
+
+static uint32_t
+profiler_total_ms(void) {
+    uint64_t total = 0;
+
+    for (int i = 0; i < PROFILER_PHASE_COUNT; i++) {
+        if (profiler_is_done(BIT(i))) {
+            total = MAX(total, profiler_marks[i]);
+        }
+    }
+    return (uint32_t)(total / 1000);
+}
+
+static void
+profiler_log_summary(void) {
+    char   summary[256];
+    size_t len = 0;
+
+    for (int i = 0; i < PROFILER_PHASE_COUNT; i++) {
+        len += snprintf(summary + len, sizeof(summary) - len, "%s %u ms, ", profiler_names[i], profiler_get_ms(i));
+        len = MIN(len, sizeof(summary) - 1);
+    }
+    LOG_INF("Boot profile: %stotal %u ms", summary, profiler_total_ms());
+}
+
+void
+profiler_mark(profiler_phase_t phase) {
+    assert(phase < PROFILER_PHASE_COUNT);
+
+    uint64_t now = profiler_now_us();
+    if (!profiler_is_done(profiler_deps[phase]) || atomic_test_and_set_bit(&profiler_claimed, phase)) {
+        return;
+    }
+    profiler_marks[phase] = now;
+    atomic_set_bit(&profiler_done, phase);
+
+    if (PROFILER_PHASE_COUNT - 1 == phase) {
+        profiler_log_summary();
+    }
+}
+
+uint32_t
+profiler_get_ms(profiler_phase_t phase) {
+    assert(phase < PROFILER_PHASE_COUNT);
+
+    if (!profiler_is_done(BIT(phase))) {
+        return 0;
+    }
+
+    return (uint32_t)((profiler_marks[phase] - profiler_start_us(phase)) / 1000);
+}
+
+static mender_err_t
+profiler_inventory_cb(mender_keystore_t **keystore, uint8_t *keystore_len) {
+    profiler_mark(PROFILER_PHASE_AUTHENTICATED);
+
+    for (int i = 0; i < PROFILER_INVENTORY_LEN; i++) {
+        uint32_t ms = (PROFILER_PHASE_COUNT == i) ? profiler_total_ms() : profiler_get_ms(i);
+        snprintf(profiler_inventory_values[i], sizeof(profiler_inventory_values[i]), "%u", ms);
+    }
+    *keystore     = profiler_inventory;
+    *keystore_len = PROFILER_INVENTORY_LEN;
+
+    return MENDER_OK;
+}
+
+mender_err_t
+profiler_add_inventory(void) {
+    for (int i = 0; i < PROFILER_INVENTORY_LEN; i++) {
+        snprintf(profiler_inventory_names[i],
+                 sizeof(profiler_inventory_names[i]),
+                 "boot_%s_ms",
+                 (PROFILER_PHASE_COUNT == i) ? "total" : profiler_names[i]);
+        profiler_inventory[i].name  = profiler_inventory_names[i];
+        profiler_inventory[i].value = profiler_inventory_values[i];
+    }
+
+    /* Persistent: the keystore is static, the client must not free it; the durations are updated
+       in place as the phases complete */
+    return mender_inventory_add_callback(profiler_inventory_cb, true);
+}
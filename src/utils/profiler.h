@@ -0,0 +1,87 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#include <mender/utils.h>
+
+/**
+ * @brief Boot phases
+ * @note The network comes up concurrently with the certs, client_init and modules phases
+ */
+typedef enum {
+    PROFILER_PHASE_KERNEL = 0,    /**< Reset until main() */
+    PROFILER_PHASE_NETWORK,       /**< Network interface up with an address */
+    PROFILER_PHASE_CERTS,         /**< TLS credentials added */
+    PROFILER_PHASE_CLIENT_INIT,   /**< mender_client_init() */
+    PROFILER_PHASE_MODULES,       /**< Update Modules registered */
+    PROFILER_PHASE_ACTIVATE,      /**< mender_client_activate() */
+    PROFILER_PHASE_AUTHENTICATED, /**< First successful authentication */
+    PROFILER_PHASE_FIRST_POLL,    /**< First deployment poll completed */
+    PROFILER_PHASE_COUNT,
+} profiler_phase_t;
+
+#ifdef CONFIG_MENDER_APP_PROFILER
+
+/**
+ * @brief Record the end of a phase
+ * @note Each phase is only recorded once, and only after the phases it waits for. Cheap enough to
+ *       be called from any callback, marks after the first one are ignored.
+ */
+void profiler_mark(profiler_phase_t phase);
+
+/**
+ * @brief Get the duration of a phase
+ * @return Duration in milliseconds, 0 if the phase has not completed yet
+ */
+uint32_t profiler_get_ms(profiler_phase_t phase);
+
+/**
+ * @brief Publish the phase durations in the inventory
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ */
+mender_err_t profiler_add_inventory(void);
+
+#else
+
+static inline void
+profiler_mark(profiler_phase_t phase) {
+    (void)phase;
+}
+
+static inline uint32_t
+profiler_get_ms(profiler_phase_t phase) {
+    (void)phase;
+    return 0;
+}
+
+static inline mender_err_t
+profiler_add_inventory(void) {
+    return MENDER_OK;
+}
+
+#endif /* CONFIG_MENDER_APP_PROFILER */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __PROFILER_H__ */
@@ -0,0 +1,247 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Every deployment status transition is appended to a journal kept in the settings, so that the
+ * transitions of a deployment interrupted by a reboot are not lost. Entries are stamped with a
+ * boot counter and the uptime, the device has no wall clock. The settings are themselves an
+ * append-only log in flash: an entry costs one write of its own and one of the indexes. The
+ * journal is a ring of the last CONFIG_MENDER_APP_STATUS_JOURNAL_SIZE transitions, whose oldest
+ * entry is overwritten by the next one.
+ *
+ * The pending entries are delivered with the logs of the next failed deployment, which the server
+ * keeps: they are appended to the stored logs when a callback of an Update Module fails, or when
+ * the client enters their failure or rollback state, before the client uploads them with the
+ * failure status. They are deleted once the server acknowledges the upload with a 2xx, and stay
+ * pending for the next failure otherwise. Like the download stages, each wrapped Update Module
+ * gets a trampoline of its own. */
+
+#include "status-journal.h"
+#include "http-observer.h"
+#include "persist.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <zephyr/kernel.h>
+
+#include <mender/storage.h>
+#include <mender/update-module.h>
+
+#define STATUS_JOURNAL_BOOT_KEY    "journal/boot"
+#define STATUS_JOURNAL_INDEXES_KEY "journal/indexes"
+#define STATUS_JOURNAL_ENTRY_KEY   "journal/%u"
+
+#define STATUS_JOURNAL_MAX_MODULES   CONFIG_MENDER_APP_UPDATE_MODULES_MAX
+#define STATUS_JOURNAL_UPDATE_STATES ARRAY_SIZE(((mender_update_module_t *)NULL)->callbacks)
+
+typedef struct {
+    uint16_t boot;
+    uint8_t  status;
+    uint8_t  reserved;
+    uint32_t uptime_s;
+} status_journal_entry_t;
+
+typedef struct {
+    uint32_t head; /* Oldest entry */
+    uint32_t tail; /* Next entry */
+} status_journal_indexes_t;
+
+static uint16_t                 status_journal_boot;
+static status_journal_indexes_t status_journal_indexes;
+
+/* Entries appended to the logs of the current deployment, up to the staged index */
+static bool     status_journal_staged;
+static uint32_t status_journal_staged_tail;
+
+static K_MUTEX_DEFINE(status_journal_lock);
+
+static void
+status_journal_key(char *buf, size_t size, uint32_t index) {
+    snprintf(buf, size, STATUS_JOURNAL_ENTRY_KEY, index % CONFIG_MENDER_APP_STATUS_JOURNAL_SIZE);
+}
+
+/* Appends the pending entries to the stored logs of the deployment, once per deployment */
+static void
+status_journal_stage(void) {
+    status_journal_entry_t entry;
+    char                   key[24];
+    char                   line[64];
+    uint32_t               i;
+
+    k_mutex_lock(&status_journal_lock, K_FOREVER);
+    if (status_journal_staged) {
+        k_mutex_unlock(&status_journal_lock);
+        return;
+    }
+    for (i = status_journal_indexes.head; i != status_journal_indexes.tail; i++) {
+        status_journal_key(key, sizeof(key), i);
+        if (sizeof(entry) != persist_load(key, &entry, sizeof(entry))) {
+            LOG_WRN("Journal entry %u lost", i);
+            continue;
+        }
+        const char *status = mender_utils_deployment_status_to_string((mender_deployment_status_t)entry.status);
+        int         len    = snprintf(
+            line, sizeof(line), "Journal: boot %u, %u s: %s", entry.boot, entry.uptime_s, (NULL != status) ? status : "unknown");
+        if (MENDER_OK != mender_storage_deployment_log_append(line, MIN((size_t)len, sizeof(line) - 1))) {
+            LOG_WRN("Unable to append the journal to the deployment logs");
+            break;
+        }
+    }
+    status_journal_staged      = true;
+    status_journal_staged_tail = i;
+    k_mutex_unlock(&status_journal_lock);
+}
+
+void
+status_journal_record(mender_deployment_status_t status) {
+    status_journal_entry_t entry = {
+        .boot     = status_journal_boot,
+        .status   = (uint8_t)status,
+        .uptime_s = (uint32_t)(k_uptime_get() / MSEC_PER_SEC),
+    };
+    status_journal_indexes_t indexes;
+    char                     key[24];
+
+    k_mutex_lock(&status_journal_lock, K_FOREVER);
+    /* The logs of a new deployment start empty */
+    if (MENDER_DEPLOYMENT_STATUS_DOWNLOADING == status) {
+        status_journal_staged = false;
+    }
+    indexes = status_journal_indexes;
+    /* Full, the oldest entry is overwritten */
+    if (indexes.tail - indexes.head >= CONFIG_MENDER_APP_STATUS_JOURNAL_SIZE) {
+        indexes.head++;
+    }
+    status_journal_key(key, sizeof(key), indexes.tail);
+    if (0 != persist_save(key, &entry, sizeof(entry))) {
+        LOG_WRN("Unable to save the journal entry");
+    } else {
+        indexes.tail++;
+        if (0 != persist_save(STATUS_JOURNAL_INDEXES_KEY, &indexes, sizeof(indexes))) {
+            LOG_WRN("Unable to save the journal indexes");
+        }
+        status_journal_indexes = indexes;
+    }
+    k_mutex_unlock(&status_journal_lock);
+}
+
+/* The upload of the logs of the deployment, with the staged entries */
+static void
+status_journal_http_cb(const struct http_request *req, uint16_t status, uint32_t retry_after) {
+    ARG_UNUSED(retry_after);
+
+    if ((HTTP_PUT != req->method) || (NULL == req->url) || (NULL == strstr(req->url, "/deployments/device/deployments/"))
+        || (NULL == strstr(req->url, "/log"))) {
+        return;
+    }
+
+    k_mutex_lock(&status_journal_lock, K_FOREVER);
+    if (status_journal_staged && (status >= 200) && (status < 300)) {
+        status_journal_indexes_t indexes = status_journal_indexes;
+
+        /* Entries overwritten since they were staged are gone already */
+        if (status_journal_staged_tail - indexes.head <= indexes.tail - indexes.head) {
+            indexes.head = status_journal_staged_tail;
+        }
+        if (0 != persist_save(STATUS_JOURNAL_INDEXES_KEY, &indexes, sizeof(indexes))) {
+            LOG_WRN("Unable to save the journal indexes");
+        } else {
+            status_journal_indexes = indexes;
+        }
+    }
+    k_mutex_unlock(&status_journal_lock);
+}
+
+typedef mender_err_t (*status_journal_cb_t)(mender_update_state_t state, mender_update_state_data_t callback_data);
+
+static status_journal_cb_t status_journal_next[STATUS_JOURNAL_MAX_MODULES][STATUS_JOURNAL_UPDATE_STATES];
+static size_t              status_journal_count;
+
+static mender_err_t
+status_journal_update_state(size_t module, mender_update_state_t state, mender_update_state_data_t callback_data) {
+    /* Inner callbacks first: the captured logs of the deployment are stored from one of them and
+       replace the logs kept so far */
+    mender_err_t ret = status_journal_next[module][state](state, callback_data);
+
+    if ((ret < MENDER_OK) || (MENDER_UPDATE_STATE_FAILURE == state) || (MENDER_UPDATE_STATE_ROLLBACK == state)) {
+        status_journal_stage();
+    }
+
+    return ret;
+}
+
+#define STATUS_JOURNAL_TRAMPOLINE(_i, _)                                                                                \
+    static mender_err_t status_journal_update_state_##_i(mender_update_state_t state, mender_update_state_data_t data) { \
+        return status_journal_update_state(_i, state, data);                                                            \
+    }
+#define STATUS_JOURNAL_TRAMPOLINE_NAME(_i, _) status_journal_update_state_##_i
+
+LISTIFY(STATUS_JOURNAL_MAX_MODULES, STATUS_JOURNAL_TRAMPOLINE, ())
+
+static const status_journal_cb_t status_journal_trampolines[STATUS_JOURNAL_MAX_MODULES]
+    = { LISTIFY(STATUS_JOURNAL_MAX_MODULES, STATUS_JOURNAL_TRAMPOLINE_NAME, (, )) };
+
+mender_err_t
+status_journal_wrap(const char *artifact_type) {
+    assert(NULL != artifact_type);
+
+    mender_update_module_t *update_module = mender_update_module_get(artifact_type);
+    if (NULL == update_module) {
+        LOG_ERR("No Update Module registered for '%s'", artifact_type);
+        return MENDER_FAIL;
+    }
+    if (status_journal_count >= STATUS_JOURNAL_MAX_MODULES) {
+        LOG_ERR("Cannot journal more than %d Update Modules", STATUS_JOURNAL_MAX_MODULES);
+        return MENDER_FAIL;
+    }
+
+    size_t i = status_journal_count++;
+    for (size_t state = 0; state < STATUS_JOURNAL_UPDATE_STATES; state++) {
+        /* The client skips the states without a callback, they stay so */
+        status_journal_next[i][state] = update_module->callbacks[state];
+        if (NULL != update_module->callbacks[state]) {
+            update_module->callbacks[state] = status_journal_trampolines[i];
+        }
+    }
+
+    return MENDER_OK;
+}
+
+mender_err_t
+status_journal_init(void) {
+    int len;
+
+    if (sizeof(status_journal_boot) != persist_load(STATUS_JOURNAL_BOOT_KEY, &status_journal_boot, sizeof(status_journal_boot))) {
+        status_journal_boot = 0;
+    }
+    status_journal_boot++;
+    if (0 != persist_save(STATUS_JOURNAL_BOOT_KEY, &status_journal_boot, sizeof(status_journal_boot))) {
+        LOG_WRN("Unable to save the boot counter");
+    }
+
+    len = persist_load(STATUS_JOURNAL_INDEXES_KEY, &status_journal_indexes, sizeof(status_journal_indexes));
+    if ((sizeof(status_journal_indexes) != len)
+        || (status_journal_indexes.tail - status_journal_indexes.head > CONFIG_MENDER_APP_STATUS_JOURNAL_SIZE)) {
+        memset(&status_journal_indexes, 0, sizeof(status_journal_indexes));
+    }
+    if (status_journal_indexes.tail != status_journal_indexes.head) {
+        LOG_INF("%u journal entries pending", status_journal_indexes.tail - status_journal_indexes.head);
+    }
+
+    return http_observer_add(status_journal_http_cb);
+}
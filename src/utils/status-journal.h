@@ -0,0 +1,50 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef __STATUS_JOURNAL_H__
+#define __STATUS_JOURNAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <mender/utils.h>
+
+/**
+ * @brief Load the journal, count the boot and observe the uploads of the deployment logs
+ * @return MENDER_OK on success, MENDER_FAIL otherwise
+ * @note To be called after mender_client_init()
+ */
+mender_err_t status_journal_init(void);
+
+/**
+ * @brief Deliver the pending entries with the logs of the deployment when a callback of a
+ *        registered Update Module fails, or when the client enters its failure or rollback state
+ * @param artifact_type Artifact type the Update Module was registered for
+ * @return MENDER_OK on success, MENDER_FAIL if the module is unknown or too many are wrapped
+ * @note To be wrapped after deploy_log_wrap(), whose stored logs replace the previous ones
+ */
+mender_err_t status_journal_wrap(const char *artifact_type);
+
+/**
+ * @brief Append a deployment status transition to the journal
+ * @note The oldest entry is overwritten when the journal is full
+ */
+void status_journal_record(mender_deployment_status_t status);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __STATUS_JOURNAL_H__ */
@@ -0,0 +1,76 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* Reports the use of the mbedTLS heap (CONFIG_MBEDTLS_HEAP_SIZE) for every TLS connection of the
+ * Mender client. The application is linked with --wrap=z_impl_zsock_close: when a socket is closed
+ * after the heap was used, the peak since the previous report is logged along with the high-water
+ * mark since boot, and what is still allocated. The allocator does not expose its free list, the
+ * number of blocks is the only hint of fragmentation it gives. zsock_connect() is wrapped too: it
+ * does the TLS handshake, its duration is reported with the heap. */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/util.h>
+
+#include <mbedtls/memory_buffer_alloc.h>
+
+#if !defined(MBEDTLS_MEMORY_DEBUG)
+#error "MBEDTLS_MEMORY_DEBUG is required, see config-tls-mender.h"
+#endif
+
+static size_t   tls_heap_high_water;
+static uint32_t tls_heap_connect_ms;
+
+int __real_z_impl_zsock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen);
+int __real_z_impl_zsock_close(int sock);
+
+int
+__wrap_z_impl_zsock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen) {
+    int64_t start = k_uptime_get();
+
+    int ret = __real_z_impl_zsock_connect(sock, addr, addrlen);
+
+    tls_heap_connect_ms = (uint32_t)(k_uptime_get() - start);
+
+    return ret;
+}
+
+int
+__wrap_z_impl_zsock_close(int sock) {
+    size_t max_used, max_blocks, cur_used, cur_blocks;
+
+    int ret = __real_z_impl_zsock_close(sock);
+
+    mbedtls_memory_buffer_alloc_max_get(&max_used, &max_blocks);
+    mbedtls_memory_buffer_alloc_cur_get(&cur_used, &cur_blocks);
+
+    /* Plain sockets do not use the heap, the peak did not move since the last report */
+    if (max_used > cur_used) {
+        tls_heap_high_water = MAX(tls_heap_high_water, max_used);
+        LOG_INF("TLS heap: peak %zu bytes in %zu blocks, high-water %zu of %d bytes, %zu bytes in %zu blocks in use, connected in %u ms",
+                max_used,
+                max_blocks,
+                tls_heap_high_water,
+                CONFIG_MBEDTLS_HEAP_SIZE,
+                cur_used,
+                cur_blocks,
+                tls_heap_connect_ms);
+        mbedtls_memory_buffer_alloc_max_reset();
+    }
+
+    return ret;
+}
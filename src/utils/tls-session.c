@@ -0,0 +1,48 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(mender_app, LOG_LEVEL_DBG);
+
+/* The Mender client creates its TLS sockets itself and does not enable the session cache of the
+ * Zephyr TLS sockets, so every request goes through a full handshake. The application is linked
+ * with --wrap=z_impl_zsock_setsockopt: when the security tags of a socket are set, which every TLS
+ * socket of the client does before connecting, the session cache is enabled on it as well. The
+ * next connection to the same server then resumes the stored session (session ID or ticket)
+ * instead of verifying the certificate chain again.
+ *
+ * The sessions are kept in RAM by the TLS sockets, up to NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT
+ * of them, and are lost on reboot. */
+
+#include <errno.h>
+
+#include <zephyr/net/socket.h>
+
+int __real_z_impl_zsock_setsockopt(int sock, int level, int optname, const void *optval, socklen_t optlen);
+
+int
+__wrap_z_impl_zsock_setsockopt(int sock, int level, int optname, const void *optval, socklen_t optlen) {
+    int ret = __real_z_impl_zsock_setsockopt(sock, level, optname, optval, optlen);
+
+    if ((0 == ret) && (SOL_TLS == level) && (TLS_SEC_TAG_LIST == optname)) {
+        int cache = TLS_SESSION_CACHE_ENABLED;
+
+        /* Not fatal, the socket simply does a full handshake */
+        if (0 != __real_z_impl_zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE, &cache, sizeof(cache))) {
+            LOG_WRN("Unable to enable the TLS session cache: %d", errno);
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,163 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+# Download throughput benchmark: deploys artifacts of increasing size to a native_sim device
+# running the 'bench-update' Update Module, which drops the payload, and reports for every size
+# the throughput seen by the device, the host CPU time of the device per MB, the peak of the
+# mbedTLS heap and the number of download callbacks. The report is written as JSON, to compare the
+# data path before and after a change:
+#
+#   python benchmark.py --output baseline.json
+#   python benchmark.py --output change.json -D CONFIG_MENDER_APP_DOWNLOAD_PIPELINE=y
+
+import os
+import re
+import sys
+import json
+import time
+import argparse
+import tempfile
+import logging
+
+import device
+
+from device import NativeSim
+from helpers import stdout
+from mock_server import MockServer, DEFAULT_HOST, DEFAULT_PORT
+
+logger = logging.getLogger(__name__)
+
+SIZES = [4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024]
+
+BENCH_RE = re.compile(
+    r"bench-update: (\d+) bytes in (\d+) ms \((\d+) B/s\), (\d+) callbacks, blocks (\d+)\.\.(\d+) bytes"
+)
+HEAP_RE = re.compile(r"TLS heap: peak (\d+) bytes in (\d+) blocks")
+
+# At least this fast, or the deployment is given up
+MIN_THROUGHPUT = 64 * 1024
+
+
+# User and system time of the process, from /proc: native_sim runs the whole device in one process
+def cpu_time(pid):
+    with open(f"/proc/{pid}/stat") as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+
+
+def build(server, build_dir, extra_variables=None):
+    device.SERVER_VARIABLES = server.device_variables()
+    sim = NativeSim(build_dir, stdout=False)
+    sim.set_host(f"https://{server.host}")
+    sim.set_tenant(server.get_tenant_token())
+    sim.compile(
+        pristine=True,
+        extra_variables=["-DCONFIG_MENDER_APP_TLS_HEAP_STATS=y"] + (extra_variables or []),
+    )
+    return sim
+
+
+def measure(server, sim, size):
+    artifact_name = server.upload_artifact(
+        f"bench-{size}-{int(time.time())}",
+        device_types=("test-device",),
+        update_module="bench-update",
+        data=os.urandom(size),
+    )
+    server.create_deployment(artifact_name, server.device_id, True)
+
+    result = {"size": size, "success": False}
+    peaks = []
+    cpu_start = cpu_time(sim.proc.pid)
+    timeout = 120 + size / MIN_THROUGHPUT
+    start_time = time.time()
+    while time.time() - start_time < timeout:
+        line = stdout(sim)
+        match = BENCH_RE.search(line)
+        if match:
+            values = [int(value) for value in match.groups()]
+            result.update(
+                bytes=values[0],
+                duration_ms=values[1],
+                bytes_per_s=values[2],
+                callbacks=values[3],
+                block_min=values[4],
+                block_max=values[5],
+            )
+            cpu = cpu_time(sim.proc.pid) - cpu_start
+            result["cpu_s"] = round(cpu, 3)
+            result["cpu_s_per_mb"] = round(cpu * 1024 * 1024 / max(values[0], 1), 3)
+        match = HEAP_RE.search(line)
+        if match:
+            peaks.append(int(match.group(1)))
+        if "deployment_status_cb: success" in line:
+            result["success"] = True
+            break
+        if "deployment_status_cb: failure" in line:
+            break
+    result["tls_heap_peak"] = max(peaks) if peaks else None
+    return result
+
+
+def run(server, build_dir, sizes=SIZES, extra_variables=None):
+    sim = build(server, build_dir, extra_variables)
+    sim.start(compile=False)
+    try:
+        if not sim.status.is_authenticated(timeout=60):
+            raise RuntimeError("The device did not authenticate")
+        # Already accepted, only looks up the id of the device
+        server.accept_device()
+        results = []
+        for size in sizes:
+            result = measure(server, sim, size)
+            logger.info(result)
+            results.append(result)
+    finally:
+        sim.stop()
+    return {"variables": extra_variables or [], "results": results}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--host", default=DEFAULT_HOST, help="Address of the server as seen by the device")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--sizes", default=",".join(str(size) for size in SIZES), help="Comma separated artifact sizes in bytes")
+    parser.add_argument("--output", default=None, help="File to write the report to, stdout otherwise")
+    parser.add_argument("--build-dir", default=None)
+    parser.add_argument("-D", dest="variables", action="append", default=[], help="Extra build variable, e.g. -DCONFIG_MENDER_APP_DOWNLOAD_PIPELINE=y")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO)
+
+    server = MockServer(host=args.host, port=args.port, auto_accept=True)
+    try:
+        report = run(
+            server,
+            args.build_dir or tempfile.mkdtemp(),
+            [int(size) for size in args.sizes.split(",")],
+            [f"-D{variable}" for variable in args.variables],
+        )
+    finally:
+        server.stop()
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=2)
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == "__main__":
+    main()
@@ -32,7 +32,9 @@ sys.path += [
     path.join(path.dirname(__file__), "mender_server/backend/tests/integration/")
 ]
 
-from server import Server
+from mock_server import MockServer
+
+import device
 
 logging.getLogger("requests").setLevel(logging.CRITICAL)
 
@@ -45,7 +47,9 @@ logger = logging.getLogger(__name__)
 
 
 @pytest.fixture(scope="session", autouse=True)
-def check_variables():
+def check_variables(request):
+    if request.config.getoption("--mock-server"):
+        return
     if "TEST_AUTH_TOKEN" not in os.environ:
         pytest.fail(f"Failed to set TEST_AUTH_TOKEN")
 
@@ -62,6 +66,24 @@ def pytest_addoption(parser):
         default="docker.mender.io",
         help="Server URL for tests",
     )
+    parser.addoption(
+        "--mock-server",
+        action="store_true",
+        default=False,
+        help="Run against a local mock server instead, see mock_server.py",
+    )
+    parser.addoption(
+        "--mock-host",
+        action="store",
+        default="192.0.2.2",
+        help="Address of the mock server as seen by the devices",
+    )
+    parser.addoption(
+        "--fleet-interfaces",
+        action="store",
+        default="zeth",
+        help="Comma separated TAP interfaces, one per device of the fleet tests",
+    )
 
 
 @pytest.fixture(scope="session", autouse=True)
@@ -73,8 +95,17 @@ def setup_user():
 
 @pytest.fixture(scope="session", autouse=True)
 def server(setup_user, request):
+    if request.config.getoption("--mock-server"):
+        mock = MockServer(host=request.config.getoption("--mock-host"))
+        device.SERVER_VARIABLES = mock.device_variables()
+        yield mock
+        mock.stop()
+        return
+    # Only needed with a real server, needs the mender_server submodule
+    from server import Server
+
     host_url = request.config.getoption("--host")
-    return Server(auth_token=setup_user, host=host_url)
+    yield Server(auth_token=setup_user, host=host_url)
 
 
 @pytest.fixture(scope="function", autouse=True)
@@ -82,6 +113,58 @@ def get_build_dir():
     return tempfile.mkdtemp()
 
 
+# With pytest-xdist every worker runs its device with its own identity, and on its own interface
+# when several are given with --fleet-interfaces
+@pytest.fixture(scope="session")
+def worker_identity(request):
+    worker = os.environ.get("PYTEST_XDIST_WORKER", "gw0")
+    index = int(worker[2:])
+    if index == 0:
+        return "11:11:22:33:55:88", []
+    interfaces = request.config.getoption("--fleet-interfaces").split(",")
+    mac = "02:00:00:00:01:%02x" % index
+    return mac, [f"--mac={mac}", f"--eth-if={interfaces[index % len(interfaces)]}"]
+
+
+# Builds shared by the tests of the session, one per set of build variables: the behaviour of
+# the test Update Module and of the callbacks is selected at runtime, see helpers.um_run_args()
+@pytest.fixture(scope="session")
+def shared_build(server):
+    builds = {}
+
+    def build(extra_variables=()):
+        key = tuple(extra_variables)
+        if key not in builds:
+            build_dir = tempfile.mkdtemp()
+            sim = device.NativeSim(build_dir)
+            sim.set_host(f"https://{server.host}")
+            sim.set_tenant(server.get_tenant_token())
+            sim.compile(pristine=True, extra_variables=list(key))
+            builds[key] = build_dir
+        return builds[key]
+
+    yield build
+
+    for index, build_dir in enumerate(builds.values()):
+        capture_coverage(build_dir, f"test_shared_build_{index}.info")
+        shutil.rmtree(build_dir)
+
+
+# A device running a shared build, with a flash of its own in the build directory of the test
+@pytest.fixture(scope="function")
+def shared_device(shared_build, get_build_dir, worker_identity):
+    def create(run_args=(), extra_variables=(), stdout=True, trace=False):
+        return device.NativeSim(
+            shared_build(extra_variables),
+            stdout=stdout,
+            flash=path.join(get_build_dir, "flash.bin"),
+            run_args=worker_identity[1] + list(run_args),
+            trace=trace,
+        )
+
+    return create
+
+
 @pytest.fixture(autouse=True, scope="function")
 def teardown():
     yield
@@ -89,15 +172,12 @@ def teardown():
         os.remove(helpers.get_header_file())
 
 
-@pytest.fixture(scope="function", autouse=True)
-def get_coverage(request, get_build_dir):
-    yield
-    test_name = f"{re.sub(r'[\[\]]', '_', request.node.name)}.info"
+def capture_coverage(build_dir, test_name):
     command = [
         "lcov",
         "--capture",
         "--directory",
-        path.join(get_build_dir, "modules/mender-mcu"),
+        path.join(build_dir, "modules/mender-mcu"),
         "--output-file",
         path.join(THIS_DIR, test_name),
         "--rc",
@@ -111,6 +191,15 @@ def get_coverage(request, get_build_dir):
         subprocess.check_call(command)
     except subprocess.CalledProcessError as err:
         pytest.fail(err.stderr)
+
+
+@pytest.fixture(scope="function", autouse=True)
+def get_coverage(request, get_build_dir):
+    yield
+    # Tests running a shared build only keep their flash here, see shared_build
+    if any(Path(get_build_dir).rglob("*.gcda")):
+        test_name = f"{re.sub(r'[\[\]]', '_', request.node.name)}.info"
+        capture_coverage(get_build_dir, test_name)
     shutil.rmtree(get_build_dir)
 
 
@@ -47,3 +47,67 @@ UM_SUPPORTS_ROLLBACK = "UM_SUPPORTS_ROLLBACK"
 
 # Mac address used in identity (used in src/callback.c)
 MAC_ADDRESS = "MAC_ADDRESS"
+
+
+################
+# Runtime options
+################
+
+# States the test Update Module fails in, see helpers.um_run_args()
+UM_FAIL = "--um-fail"
+# Update module requires reboot
+UM_REBOOT = "--um-reboot"
+# Update module supports rollback
+UM_ROLLBACK = "--um-rollback"
+# Seconds to sleep in the first download callback
+UM_DOWNLOAD_SLEEP = "--um-download-sleep"
+# Mac address used in identity
+MAC = "--mac"
+
+################
+# Event trace
+################
+
+# Event types, see src/utils/event-trace.h
+TRACE_BOOT = 1
+TRACE_NETWORK = 2
+TRACE_HTTP_RESPONSE = 3
+TRACE_DEPLOYMENT_STATUS = 4
+TRACE_UPDATE_STATE_ENTER = 5
+TRACE_UPDATE_STATE_EXIT = 6
+TRACE_DOWNLOAD = 7
+TRACE_HEAP_TLS = 8
+TRACE_HEAP_POOL = 9
+
+# Requests of the client, b of TRACE_HTTP_RESPONSE
+TRACE_ENDPOINT_OTHER = 0
+TRACE_ENDPOINT_AUTH = 1
+TRACE_ENDPOINT_NEXT = 2
+TRACE_ENDPOINT_STATUS = 3
+TRACE_ENDPOINT_LOG = 4
+TRACE_ENDPOINT_INVENTORY = 5
+
+# mender_deployment_status_t, in mender/utils.h
+DEPLOYMENT_STATUSES = [
+    "downloading",
+    "installing",
+    "rebooting",
+    "success",
+    "failure",
+    "already-installed",
+]
+
+# mender_update_state_t, in mender/update-module.h
+UPDATE_STATES = [
+    "MENDER_UPDATE_STATE_DOWNLOAD",
+    "MENDER_UPDATE_STATE_INSTALL",
+    "MENDER_UPDATE_STATE_REBOOT",
+    "MENDER_UPDATE_STATE_VERIFY_REBOOT",
+    "MENDER_UPDATE_STATE_COMMIT",
+    "MENDER_UPDATE_STATE_CLEANUP",
+    "MENDER_UPDATE_STATE_ROLLBACK",
+    "MENDER_UPDATE_STATE_ROLLBACK_REBOOT",
+    "MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT",
+    "MENDER_UPDATE_STATE_FAILURE",
+    "MENDER_UPDATE_STATE_END",
+]
@@ -14,11 +14,15 @@
 
 import os
 import time
+import fcntl
 import pytest
 import shutil
+import struct
 import tempfile
+import threading
 import subprocess
 import logging
+import collections
 
 logger = logging.getLogger(__name__)
 
@@ -26,9 +30,106 @@ from helpers import stdout
 from helpers import create_header_file
 from helpers import THIS_DIR
 
+import definitions
+
 # This has to point the west workspace containing mender-mcu-integration
 WORKSPACE_DIRECTORY = os.path.join(THIS_DIR, "../../")
 
+# Build variables every device needs for the server in use, see MockServer.device_variables()
+SERVER_VARIABLES = []
+
+
+# Event of the trace, see src/utils/event-trace.h; time_us is since the start of the device, and
+# keeps counting across its restarts
+TraceEvent = collections.namedtuple("TraceEvent", ["type", "sequence", "time_us", "a", "b"])
+
+TRACE_EVENT = struct.Struct("<BBHIII")
+TRACE_SYNC = 0xA5
+F_SETPIPE_SZ = 1031
+
+
+# Decoder of the event trace (CONFIG_MENDER_APP_EVENT_TRACE) of a native_sim device, read from a
+# pipe which the device writes to with --trace-fd. The write end is non-blocking: the device drops
+# events rather than stopping when nothing reads them.
+class Trace:
+    def __init__(self):
+        self.read_fd, self.write_fd = os.pipe()
+        os.set_blocking(self.write_fd, False)
+        try:
+            fcntl.fcntl(self.write_fd, F_SETPIPE_SZ, 1024 * 1024)
+        except OSError:
+            pass
+        self.events = []
+        self.dropped = 0
+        self.condition = threading.Condition()
+        self.sequence = None
+        self.base_us = 0
+        self.last_us = 0
+        self.reader = threading.Thread(target=self.read, daemon=True)
+        self.reader.start()
+
+    def run_args(self):
+        return [f"--trace-fd={self.write_fd}"]
+
+    def read(self):
+        data = b""
+        while True:
+            try:
+                chunk = os.read(self.read_fd, 4096)
+            except OSError:
+                return
+            if not chunk:
+                return
+            data += chunk
+            while len(data) >= TRACE_EVENT.size:
+                # Resynchronize on the sync byte, should a partial event ever be written
+                if data[0] != TRACE_SYNC:
+                    data = data[1:]
+                    continue
+                self.decode(TRACE_EVENT.unpack_from(data))
+                data = data[TRACE_EVENT.size :]
+
+    def decode(self, fields):
+        _, kind, sequence, time_us, a, b = fields
+        if kind == definitions.TRACE_BOOT:
+            # Restarted: the sequence and the clock start over
+            self.base_us = self.last_us
+            self.sequence = None
+        elif time_us + self.base_us < self.last_us - (1 << 31):
+            # The 32 bit clock wrapped
+            self.base_us += 1 << 32
+        if self.sequence is not None:
+            self.dropped += (sequence - self.sequence - 1) & 0xFFFF
+        self.sequence = sequence
+        self.last_us = time_us + self.base_us
+        with self.condition:
+            self.events.append(TraceEvent(kind, sequence, self.last_us, a, b))
+            self.condition.notify_all()
+
+    # Waits for an event matching predicate, from the index given on; returns its index and the
+    # event, or (None, None) on timeout
+    def wait_for(self, predicate, timeout=60, start=0):
+        deadline = time.time() + timeout
+        index = start
+        with self.condition:
+            while True:
+                while index < len(self.events):
+                    if predicate(self.events[index]):
+                        return index, self.events[index]
+                    index += 1
+                remaining = deadline - time.time()
+                if remaining <= 0:
+                    return None, None
+                self.condition.wait(remaining)
+
+    def of_type(self, kind):
+        with self.condition:
+            return [event for event in self.events if event.type == kind]
+
+    def close(self):
+        os.close(self.write_fd)
+        os.close(self.read_fd)
+
 
 class DeviceStatus:
     def __init__(self, device):
@@ -36,6 +137,14 @@ class DeviceStatus:
 
     def is_authenticated(self, timeout=60):
         logger.info("Waiting for device to authenticate")
+        if self.device.trace is not None:
+            _, event = self.device.trace.wait_for(
+                lambda event: event.type == definitions.TRACE_HTTP_RESPONSE
+                and event.b == definitions.TRACE_ENDPOINT_AUTH
+                and event.a == 200,
+                timeout,
+            )
+            return event is not None
         start_time = time.time()
         while time.time() - start_time < timeout:
             line = stdout(self.device)
@@ -55,10 +164,15 @@ class DeviceStatus:
 
 
 class NativeSim:
-    def __init__(self, build_dir, stdout=False):
+    def __init__(self, build_dir, stdout=False, flash=None, run_args=None, trace=False):
         self.tenant_token = "..."
         self.proc = None
         self.stdout = stdout
+        # Several instances of the same build need a flash of their own
+        self.flash = flash
+        self.run_args = run_args or []
+        # Needs a build with CONFIG_MENDER_APP_EVENT_TRACE
+        self.trace = Trace() if trace else None
 
         self.server_host = ""
         self.server_tenant = ""
@@ -87,7 +201,8 @@ class NativeSim:
                 "-DBUILD_INTEGRATION_TESTS=ON",
                 f'-DCONFIG_MENDER_SERVER_HOST="{self.server_host}"',
                 f'-DCONFIG_MENDER_SERVER_TENANT_TOKEN="{self.server_tenant}"',
-            ] + extra_variables
+            ]
+            variables += SERVER_VARIABLES + extra_variables
 
             command = (
                 [
@@ -122,14 +237,19 @@ class NativeSim:
         if compile:
             self.compile(pristine=pristine, extra_variables=extra_variables)
 
+        flash = self.flash or f"{self.build_dir}/flash.bin"
+        trace_args = self.trace.run_args() if self.trace else []
         self.proc = subprocess.Popen(
             [
                 f"{self.build_dir}/zephyr/zephyr.exe",
-                f"--flash={self.build_dir}/flash.bin",
-            ],
+                f"--flash={flash}",
+            ]
+            + self.run_args
+            + trace_args,
             stdout=subprocess.PIPE,
             stderr=subprocess.PIPE,
             text=True,
+            pass_fds=(self.trace.write_fd,) if self.trace else (),
         )
         logger.info("Started device")
 
@@ -0,0 +1,157 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+# Runs a fleet of native_sim devices from a single build against the mock server, and reports the
+# load they put on it. Every device runs on a TAP interface of its own (--eth-if) with a distinct
+# MAC identity (--mac), and keeps its own flash.
+#
+#   python fleet.py --interfaces zeth0,zeth1,zeth2 --duration 300 --deploy-after 60
+
+import os
+import sys
+import json
+import time
+import argparse
+import tempfile
+import threading
+import logging
+
+import device
+
+from device import NativeSim
+from mock_server import MockServer, DEFAULT_HOST, DEFAULT_PORT
+
+logger = logging.getLogger(__name__)
+
+
+def mac_address(index):
+    return "02:00:00:%02x:%02x:%02x" % ((index >> 16) & 0xFF, (index >> 8) & 0xFF, index & 0xFF)
+
+
+class Fleet:
+    def __init__(self, server, build_dir, interfaces):
+        self.server = server
+        self.build_dir = build_dir
+        self.devices = []
+        self.readers = []
+        self.authenticated = {}
+        self.lock = threading.Lock()
+
+        for index, interface in enumerate(interfaces):
+            self.devices.append(
+                NativeSim(
+                    build_dir,
+                    flash=os.path.join(build_dir, f"flash-{index}.bin"),
+                    run_args=[f"--eth-if={interface}", f"--mac={mac_address(index)}"],
+                )
+            )
+
+    def build(self, extra_variables=None):
+        device.SERVER_VARIABLES = self.server.device_variables()
+        builder = self.devices[0]
+        builder.set_host(f"https://{self.server.host}")
+        builder.set_tenant(self.server.get_tenant_token())
+        builder.compile(pristine=True, extra_variables=extra_variables)
+
+    # The output has to be consumed, or the devices block on a full pipe
+    def read(self, index, sim, started):
+        for line in sim.proc.stdout:
+            if "Authenticated successfully" in line:
+                with self.lock:
+                    self.authenticated.setdefault(index, time.time() - started)
+
+    def start(self):
+        for index, sim in enumerate(self.devices):
+            sim.start(compile=False)
+            reader = threading.Thread(
+                target=self.read, args=(index, sim, time.time()), daemon=True
+            )
+            reader.start()
+            self.readers.append(reader)
+
+    def deploy(self, size):
+        artifact_name = self.server.upload_artifact(
+            "fleet-artifact", device_types=("test-device",), data=os.urandom(size)
+        )
+        with self.server.lock:
+            device_ids = [dev["id"] for dev in self.server.devices.values()]
+        return self.server.create_deployment(artifact_name, device_ids, True)
+
+    def stop(self):
+        for sim in self.devices:
+            sim.stop()
+
+    def report(self):
+        report = self.server.stats.report()
+        with self.lock:
+            report["devices"] = len(self.devices)
+            report["authenticated"] = len(self.authenticated)
+            report["time_to_auth_s"] = sorted(self.authenticated.values())
+        if self.server.deployment_id:
+            statuses = self.server.deployment_statuses()
+            report["deployment"] = {
+                status: list(statuses.values()).count(status)
+                for status in set(statuses.values())
+            }
+        return report
+
+
+def run(server, build_dir, interfaces, duration, deploy_after=None, artifact_size=0, extra_variables=None):
+    fleet = Fleet(server, build_dir, interfaces)
+    fleet.build(extra_variables)
+    fleet.start()
+    try:
+        started = time.time()
+        if deploy_after is not None:
+            time.sleep(deploy_after)
+            fleet.deploy(artifact_size)
+        time.sleep(max(0, duration - (time.time() - started)))
+    finally:
+        fleet.stop()
+    return fleet.report()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--interfaces", default="zeth", help="Comma separated TAP interfaces, one device each")
+    parser.add_argument("--host", default=DEFAULT_HOST, help="Address of the server as seen by the devices")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--duration", type=int, default=300, help="Seconds to run the fleet")
+    parser.add_argument("--deploy-after", type=int, default=None, help="Seconds before deploying to all the devices")
+    parser.add_argument("--artifact-size", type=int, default=256 * 1024)
+    parser.add_argument("--build-dir", default=None)
+    parser.add_argument("-D", dest="variables", action="append", default=[], help="Extra build variable, e.g. -DCONFIG_MENDER_APP_POLL_SCHED=y")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO)
+
+    server = MockServer(host=args.host, port=args.port, auto_accept=True)
+    try:
+        report = run(
+            server,
+            args.build_dir or tempfile.mkdtemp(),
+            args.interfaces.split(","),
+            args.duration,
+            args.deploy_after,
+            args.artifact_size,
+            [f"-D{variable}" for variable in args.variables],
+        )
+    finally:
+        server.stop()
+    json.dump(report, sys.stdout, indent=2)
+    print()
+
+
+if __name__ == "__main__":
+    main()
@@ -14,8 +14,10 @@
 
 import os
 import random
+import struct
 import string
 import tempfile
+import time
 import subprocess
 
 from os import path
@@ -23,6 +25,8 @@ from contextlib import contextmanager
 
 import logging
 
+import definitions
+
 logger = logging.getLogger(__name__)
 
 
@@ -50,6 +54,24 @@ def set_define(define_name, definition):
         f.write(f"#define {define_name} {definition}\n")
 
 
+# Runtime options of the test Update Module, see src/modules/test-update-module.c. States are
+# given as in the logs of the client, e.g. MENDER_UPDATE_STATE_COMMIT
+def um_run_args(
+    fail_in=(), requires_reboot=False, supports_rollback=False, download_sleep=0
+):
+    args = []
+    if fail_in:
+        states = [state[len("MENDER_UPDATE_STATE_") :].lower() for state in fail_in]
+        args.append(f"{definitions.UM_FAIL}={','.join(states)}")
+    if requires_reboot:
+        args.append(definitions.UM_REBOOT)
+    if supports_rollback:
+        args.append(definitions.UM_ROLLBACK)
+    if download_sleep:
+        args.append(f"{definitions.UM_DOWNLOAD_SLEEP}={download_sleep}")
+    return args
+
+
 def stdout(device):
     line = device.proc.stdout.readline()
     if device.stdout:
@@ -58,6 +80,52 @@ def stdout(device):
     return line
 
 
+# The first line of the output of the device containing the text, None if none came in time
+def wait_for_line(device, text, timeout=60):
+    start_time = time.time()
+    while time.time() - start_time < timeout:
+        line = stdout(device)
+        if text in line:
+            return line
+    return None
+
+
+# Payload compression understood by the device, see src/utils/download-decompress.h
+def heatshrink_compress(data, window_sz2=8, lookahead_sz2=4):
+    window = 1 << window_sz2
+    lookahead = 1 << lookahead_sz2
+    bits = []
+
+    def put(value, count):
+        bits.extend((value >> (count - 1 - i)) & 1 for i in range(count))
+
+    pos = 0
+    while pos < len(data):
+        # Longest match starting in the window, the match may overlap the current position
+        start = max(0, pos - window)
+        best_len, best_index = 0, 0
+        for length in range(2, min(lookahead, len(data) - pos) + 1):
+            found = data.rfind(data[pos : pos + length], start, pos + length - 1)
+            if found < 0:
+                break
+            best_len, best_index = length, pos - found
+        if best_len:
+            put(0, 1)
+            put(best_index - 1, window_sz2)
+            put(best_len - 1, lookahead_sz2)
+            pos += best_len
+        else:
+            put(1, 1)
+            put(data[pos], 8)
+            pos += 1
+
+    bits.extend([0] * (-len(bits) % 8))
+    body = bytes(
+        int("".join(str(b) for b in bits[i : i + 8]), 2) for i in range(0, len(bits), 8)
+    )
+    return b"HS" + struct.pack("<BBI", window_sz2, lookahead_sz2, len(data)) + body
+
+
 # get_mender_artifact from testutils/common.py didn't support uncompressed artifacts
 @contextmanager
 def get_uncompressed_mender_artifact(
@@ -67,10 +135,20 @@ def get_uncompressed_mender_artifact(
     size=256,
     depends=(),
     provides=(),
+    data=None,
+    compress=False,
 ):
-    data = "".join(random.choices(string.ascii_uppercase + string.digits, k=size))
-    f = tempfile.NamedTemporaryFile(delete=False)
-    f.write(data.encode("utf-8"))
+    if data is None:
+        data = "".join(
+            random.choices(string.ascii_uppercase + string.digits, k=size)
+        ).encode("utf-8")
+    # The artifact itself stays uncompressed, the device decompresses ".hs" payloads
+    suffix = ""
+    if compress:
+        data = heatshrink_compress(data)
+        suffix = ".hs"
+    f = tempfile.NamedTemporaryFile(suffix=suffix, delete=False)
+    f.write(data)
     f.close()
     #
     filename = f.name
@@ -0,0 +1,519 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+# Local stand-in for the Mender Server: the device facing authentication, inventory and
+# deployments APIs, and the management operations of server.Server used by the tests. Requests
+# are counted to report the load a fleet puts on a server. Authentication requests are not
+# verified against the device key.
+
+import os
+import re
+import ssl
+import json
+import time
+import uuid
+import base64
+import logging
+import tempfile
+import threading
+import subprocess
+import collections
+
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse
+
+from helpers import THIS_DIR
+from helpers import get_uncompressed_mender_artifact
+
+logger = logging.getLogger(__name__)
+
+# Host side address of the zeth interface set up by net-setup.sh
+DEFAULT_HOST = "192.0.2.2"
+DEFAULT_PORT = 8443
+
+URL_AUTH = "/api/devices/v1/authentication/auth_requests"
+URL_INVENTORY = "/api/devices/v1/inventory/device/attributes"
+URL_NEXT_V1 = "/api/devices/v1/deployments/device/deployments/next"
+URL_NEXT_V2 = "/api/devices/v2/deployments/device/deployments/next"
+URL_DEPLOYMENTS = "/api/devices/v1/deployments/device/deployments/"
+URL_ARTIFACTS = "/artifacts/"
+
+RANGE_RE = re.compile(r"bytes=(\d+)-$")
+
+WORKSPACE_DIRECTORY = os.path.join(THIS_DIR, "../../")
+
+
+def generate_certificate(directory, host):
+    key = os.path.join(directory, "server.key")
+    pem = os.path.join(directory, "server.crt")
+    der = os.path.join(directory, "server.der")
+    san = f"IP:{host}" if host.replace(".", "").isdigit() else f"DNS:{host}"
+    # P-256, which the device supports for the Mender demo certificates already
+    subprocess.check_call(
+        [
+            "openssl",
+            "req",
+            "-x509",
+            "-newkey",
+            "ec",
+            "-pkeyopt",
+            "ec_paramgen_curve:prime256v1",
+            "-nodes",
+            "-days",
+            "30",
+            "-subj",
+            f"/CN={host}",
+            "-addext",
+            f"subjectAltName={san}",
+            "-keyout",
+            key,
+            "-out",
+            pem,
+        ],
+        stdout=subprocess.DEVNULL,
+        stderr=subprocess.DEVNULL,
+    )
+    subprocess.check_call(
+        ["openssl", "x509", "-in", pem, "-outform", "der", "-out", der]
+    )
+    return key, pem, der
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.start = time.time()
+        self.requests = collections.Counter()
+        self.latency = collections.defaultdict(list)
+        self.per_second = collections.Counter()
+        self.handshakes = 0
+        self.resumed = 0
+        self.handshake_durations = []
+        self.polls = collections.defaultdict(list)
+        self.downloads = []
+
+    def request(self, kind, started):
+        now = time.time()
+        with self.lock:
+            self.requests[kind] += 1
+            self.latency[kind].append(now - started)
+            self.per_second[int(now)] += 1
+
+    def handshake(self, resumed, duration):
+        with self.lock:
+            self.handshakes += 1
+            self.resumed += int(resumed)
+            self.handshake_durations.append(duration)
+
+    def poll(self, mac):
+        with self.lock:
+            self.polls[mac].append(time.time())
+
+    def download(self, size, duration):
+        with self.lock:
+            self.downloads.append((size, duration))
+
+    def report(self):
+        with self.lock:
+            elapsed = max(time.time() - self.start, 1e-3)
+            total = sum(self.requests.values())
+            intervals = [
+                b - a
+                for polls in self.polls.values()
+                for a, b in zip(polls, polls[1:])
+            ]
+            first_polls = [polls[0] - self.start for polls in self.polls.values()]
+            return {
+                "elapsed_s": elapsed,
+                "requests": dict(self.requests),
+                "rps_mean": total / elapsed,
+                "rps_peak": max(self.per_second.values(), default=0),
+                "latency_ms": {
+                    kind: 1000 * sum(values) / len(values)
+                    for kind, values in self.latency.items()
+                },
+                "handshakes": self.handshakes,
+                "handshakes_resumed": self.resumed,
+                "handshake_ms": (
+                    1000 * sum(self.handshake_durations) / len(self.handshake_durations)
+                    if self.handshake_durations
+                    else None
+                ),
+                "devices_polling": len(self.polls),
+                "first_poll_s": sorted(first_polls),
+                "poll_interval_s": (
+                    sum(intervals) / len(intervals) if intervals else None
+                ),
+                "download_bps": [
+                    size / duration for size, duration in self.downloads if duration
+                ],
+            }
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, format, *args):
+        logger.debug("%s %s" % (self.address_string(), format % args))
+
+    def reply(self, status, body=b"", content_type="application/json", headers=None):
+        if isinstance(body, (dict, list)):
+            body = json.dumps(body).encode()
+        elif isinstance(body, str):
+            body = body.encode()
+        self.send_response(status)
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        if body:
+            self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if body:
+            self.wfile.write(body)
+
+    def body(self):
+        length = int(self.headers.get("Content-Length", 0))
+        return self.rfile.read(length) if length else b""
+
+    def device(self):
+        auth = self.headers.get("Authorization", "")
+        if not auth.startswith("Bearer "):
+            return None
+        return self.server.mock.device_by_token(auth[len("Bearer ") :])
+
+    def handle_request(self, method):
+        started = time.time()
+        path = urlparse(self.path).path
+        mock = self.server.mock
+        kind = mock.classify(method, path)
+        body = self.body()
+
+        try:
+            retry_after = mock.throttled()
+            if retry_after is not None and not path.startswith(URL_ARTIFACTS):
+                self.reply(429, headers={"Retry-After": str(retry_after)})
+                return
+            if kind == "auth":
+                self.reply(*mock.authenticate(json.loads(body or b"{}")))
+                return
+            if kind == "download":
+                self.download(path[len(URL_ARTIFACTS) :])
+                return
+            device = self.device()
+            if device is None:
+                self.reply(401)
+            elif kind == "inventory":
+                device["inventory"] = json.loads(body or b"[]")
+                self.reply(200)
+            elif kind == "next":
+                self.server.mock.stats.poll(device["mac"])
+                self.reply(*mock.next_deployment(device, self.headers))
+            elif kind == "status":
+                deployment_id = path[len(URL_DEPLOYMENTS) :].split("/")[0]
+                status = json.loads(body or b"{}").get("status")
+                self.reply(mock.deployment_status(device, deployment_id, status))
+            elif kind == "log":
+                device["logs"].append(body)
+                self.reply(204)
+            else:
+                self.reply(404)
+        finally:
+            mock.stats.request(kind, started)
+
+    def download(self, name):
+        mock = self.server.mock
+        data = mock.artifacts.get(name)
+        if data is None:
+            self.reply(404)
+            return
+
+        status, start, headers = 200, 0, {"Accept-Ranges": "bytes"}
+        match = RANGE_RE.match(self.headers.get("Range", "").strip())
+        if match and int(match.group(1)) < len(data):
+            status, start = 206, int(match.group(1))
+            headers["Content-Range"] = f"bytes {start}-{len(data) - 1}/{len(data)}"
+        cut = mock.download_started(name, start)
+
+        started = time.time()
+        if cut is None or cut >= len(data) - start:
+            self.reply(status, data[start:], content_type="application/vnd.mender-artifact", headers=headers)
+            mock.stats.download(len(data) - start, time.time() - started)
+            return
+
+        # Announce the whole body, send part of it and drop the connection
+        self.send_response(status)
+        for header, value in headers.items():
+            self.send_header(header, value)
+        self.send_header("Content-Type", "application/vnd.mender-artifact")
+        self.send_header("Content-Length", str(len(data) - start))
+        self.end_headers()
+        self.wfile.write(data[start : start + cut])
+        self.wfile.flush()
+        self.close_connection = True
+
+    def do_GET(self):
+        self.handle_request("GET")
+
+    def do_POST(self):
+        self.handle_request("POST")
+
+    def do_PUT(self):
+        self.handle_request("PUT")
+
+    def do_PATCH(self):
+        self.handle_request("PATCH")
+
+
+class TLSServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, mock, context):
+        self.mock = mock
+        self.context = context
+        super().__init__(address, Handler)
+
+    # The handshake is done in the thread of the request, not in the one accepting. Its time
+    # includes the device verifying the certificate
+    def finish_request(self, request, client_address):
+        started = time.time()
+        try:
+            request = self.context.wrap_socket(request, server_side=True)
+        except (ssl.SSLError, OSError) as err:
+            logger.debug(f"TLS handshake with {client_address} failed: {err}")
+            return
+        self.mock.stats.handshake(request.session_reused, time.time() - started)
+        super().finish_request(request, client_address)
+
+
+class MockServer:
+    def __init__(self, host=DEFAULT_HOST, port=DEFAULT_PORT, auto_accept=False):
+        self.address = host
+        self.port = port
+        self.host = f"{host}:{port}"
+        self.auto_accept = auto_accept
+        self.deployment_id = ""
+        self.device_id = ""
+
+        self.lock = threading.Lock()
+        self.devices = {}
+        self.artifacts = {}
+        self.artifact_types = {}
+        self.deployments = {}
+        self.throttle_until = 0
+        self.retry_after = 0
+        self.cuts = []
+        self.downloads = []
+        self.stats = Stats()
+
+        self.directory = tempfile.mkdtemp()
+        key, pem, self.certificate = generate_certificate(self.directory, host)
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(pem, key)
+
+        self.httpd = TLSServer(("0.0.0.0", port), self, context)
+        self.thread = threading.Thread(target=self.httpd.serve_forever, daemon=True)
+        self.thread.start()
+        logger.info(f"Mock server listening on {self.host}")
+
+    def stop(self):
+        self.httpd.shutdown()
+        self.httpd.server_close()
+
+    # Build variables making the device trust this server
+    def device_variables(self):
+        certificate = os.path.relpath(self.certificate, WORKSPACE_DIRECTORY)
+        return [
+            "-DCONFIG_MENDER_SERVER_HOST_ON_PREM=y",
+            f'-DCONFIG_MENDER_APP_SERVER_HOST_ON_PREM_CERT="{certificate}"',
+        ]
+
+    def classify(self, method, path):
+        if path == URL_AUTH:
+            return "auth"
+        if path == URL_INVENTORY:
+            return "inventory"
+        if path in (URL_NEXT_V1, URL_NEXT_V2):
+            return "next"
+        if path.startswith(URL_DEPLOYMENTS) and path.endswith("/status"):
+            return "status"
+        if path.startswith(URL_DEPLOYMENTS) and path.endswith("/log"):
+            return "log"
+        if path.startswith(URL_ARTIFACTS):
+            return "download"
+        return "unknown"
+
+    # Answer every device request with 429 for the given time
+    def throttle(self, seconds, retry_after=None):
+        with self.lock:
+            self.throttle_until = time.time() + seconds
+            self.retry_after = retry_after if retry_after is not None else seconds
+
+    def throttled(self):
+        with self.lock:
+            if time.time() < self.throttle_until:
+                return self.retry_after
+        return None
+
+    # Drop the connection of the next downloads after the given number of bytes each
+    def cut_downloads(self, *after):
+        with self.lock:
+            self.cuts = list(after)
+
+    # Records the download, returns the number of bytes to send before dropping it
+    def download_started(self, name, start):
+        with self.lock:
+            self.downloads.append((name, start))
+            return self.cuts.pop(0) if self.cuts else None
+
+    def authenticate(self, request):
+        identity = json.loads(request.get("id_data", "{}"))
+        mac = identity.get("mac")
+        if mac is None:
+            return (400,)
+        with self.lock:
+            device = self.devices.get(mac)
+            if device is None:
+                device = {
+                    "id": str(uuid.uuid4()),
+                    "mac": mac,
+                    "status": "accepted" if self.auto_accept else "pending",
+                    "token": None,
+                    "inventory": [],
+                    "logs": [],
+                }
+                self.devices[mac] = device
+            if device["status"] != "accepted":
+                return (401,)
+            claims = base64.urlsafe_b64encode(
+                json.dumps({"sub": device["id"], "mender.device": True}).encode()
+            ).rstrip(b"=")
+            device["token"] = f"eyJhbGciOiJub25lIn0.{claims.decode()}.{uuid.uuid4().hex}"
+            return (200, device["token"], "application/jwt")
+
+    # Forgets the tokens of every device, the next requests get a 401
+    def revoke_tokens(self):
+        with self.lock:
+            for device in self.devices.values():
+                device["token"] = None
+
+    def device_by_token(self, token):
+        with self.lock:
+            for device in self.devices.values():
+                if device["token"] == token:
+                    return device
+        return None
+
+    def next_deployment(self, device, headers):
+        with self.lock:
+            for deployment in self.deployments.values():
+                if device["id"] not in deployment["devices"]:
+                    continue
+                if deployment["statuses"].get(device["id"]) in (
+                    "success",
+                    "failure",
+                    "already-installed",
+                ):
+                    continue
+                if deployment["aborted"]:
+                    continue
+                host = headers.get("Host", self.host)
+                return (
+                    200,
+                    {
+                        "id": deployment["id"],
+                        "artifact": {
+                            "artifact_name": deployment["artifact_name"],
+                            "source": {
+                                "uri": f"https://{host}{URL_ARTIFACTS}{deployment['artifact_name']}",
+                                "expire": "2099-01-01T00:00:00Z",
+                            },
+                            "device_types_compatible": deployment["device_types"],
+                        },
+                    },
+                )
+        return (204,)
+
+    def deployment_status(self, device, deployment_id, status):
+        with self.lock:
+            deployment = self.deployments.get(deployment_id)
+            if deployment is None:
+                return 404
+            if deployment["aborted"]:
+                return 409
+            deployment["statuses"][device["id"]] = status
+            # The device gets the deployment again with its next poll
+            retries = deployment["retries"].get(device["id"], deployment["max_retries"])
+            if status == "failure" and retries > 0:
+                deployment["retries"][device["id"]] = retries - 1
+                del deployment["statuses"][device["id"]]
+        return 204
+
+    # Management operations, same as server.Server
+
+    def get_tenant_token(self):
+        return "mock-tenant-token"
+
+    def accept_device(self, mac_address="11:11:22:33:55:88", timeout=10):
+        start_time = time.time()
+        while time.time() - start_time < timeout:
+            with self.lock:
+                device = self.devices.get(mac_address)
+                if device is not None:
+                    device["status"] = "accepted"
+                    self.device_id = device["id"]
+                    return
+            time.sleep(0.5)
+
+    def upload_artifact(
+        self, name, device_types, update_module="test-update", data=None, compress=False
+    ):
+        with get_uncompressed_mender_artifact(
+            name,
+            device_types=device_types,
+            update_module=update_module,
+            data=data,
+            compress=compress,
+        ) as filename:
+            with open(filename, "rb") as f:
+                self.artifacts[name] = f.read()
+        self.artifact_types[name] = list(device_types)
+        return name
+
+    def create_deployment(self, artifact_name, device_id, force=False, retries=0):
+        device_ids = device_id if isinstance(device_id, (list, tuple)) else [device_id]
+        deployment_id = str(uuid.uuid4())
+        with self.lock:
+            self.deployments[deployment_id] = {
+                "id": deployment_id,
+                "artifact_name": artifact_name,
+                "device_types": self.artifact_types.get(artifact_name, []),
+                "devices": list(device_ids),
+                "statuses": {},
+                "aborted": False,
+                "max_retries": retries,
+                "retries": {},
+            }
+        self.deployment_id = deployment_id
+        return deployment_id
+
+    def abort_deployment(self):
+        with self.lock:
+            deployment = self.deployments.get(self.deployment_id)
+            if deployment is not None:
+                deployment["aborted"] = True
+
+    def deployment_statuses(self, deployment_id=None):
+        with self.lock:
+            deployment = self.deployments.get(deployment_id or self.deployment_id)
+            return dict(deployment["statuses"]) if deployment else {}
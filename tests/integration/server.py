@@ -102,7 +102,7 @@ class Server:
             body={"status": "aborted"},
         )
 
-    def create_deployment(self, artifact_name, device_id, force=False):
+    def create_deployment(self, artifact_name, device_id, force=False, retries=0):
         logger.info("Creating deployment")
         response = self.api_dev_deploy.with_auth(self.auth_token).call(
             "POST",
@@ -112,14 +112,26 @@ class Server:
                 "artifact_name": artifact_name,
                 "devices": [device_id],
                 "force_installation": force,
+                "retries": retries,
             },
         )
         assert response.status_code == 201, f"{response.text} {response.status_code}"
         self.deployment_id = os.path.basename(response.headers["Location"])
 
-    def upload_artifact(self, name, device_types):
+    def upload_artifact(
+        self,
+        name,
+        device_types,
+        update_module="test-update",
+        data=None,
+        compress=False,
+    ):
         with get_uncompressed_mender_artifact(
-            name, device_types=device_types, update_module="test-update"
+            name,
+            device_types=device_types,
+            update_module=update_module,
+            data=data,
+            compress=compress,
         ) as filename:
 
             upload_image(filename, self.auth_token, self.api_dev_deploy)
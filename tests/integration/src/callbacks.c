@@ -57,6 +57,40 @@ mender_restart_cb(void) {
 #endif /* MAC_ADDRESS */
 static char mac_address[18] = MAC_ADDRESS;
 
+#ifdef CONFIG_ARCH_POSIX
+#include <string.h>
+
+#include "cmdline.h"
+#include "posix_native_task.h"
+
+/* --mac=<address> replaces MAC_ADDRESS at runtime, so that one build can run as several devices */
+static char *mac_address_option;
+
+static void
+mac_address_option_found(char *argv, int offset) {
+    ARG_UNUSED(argv);
+    ARG_UNUSED(offset);
+    strncpy(mac_address, mac_address_option, sizeof(mac_address) - 1);
+}
+
+static void
+add_mac_address_option(void) {
+    static struct args_struct_t mac_address_options[] = {
+        { .option          = "mac",
+          .name            = "address",
+          .type            = 's',
+          .dest            = (void *)&mac_address_option,
+          .call_when_found = mac_address_option_found,
+          .descript        = "MAC address used as the identity of the device" },
+        ARG_TABLE_ENDMARKER,
+    };
+
+    native_add_command_line_opts(mac_address_options);
+}
+
+NATIVE_TASK(add_mac_address_option, PRE_BOOT_1, 10);
+#endif /* CONFIG_ARCH_POSIX */
+
 static mender_identity_t mender_identity = { .name = "mac", .value = mac_address };
 
 mender_err_t
@@ -0,0 +1,92 @@
+// Copyright 2025 Northern.tech AS
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#include <mender/alloc.h>
+#include <mender/client.h>
+#include <mender/log.h>
+#include <mender/utils.h>
+#include <mender/update-module.h>
+
+#include <zephyr/kernel.h>
+
+/* Update Module measuring the data path of the client, see benchmark.py. The payload is dropped,
+ * only the blocks handed to the download callback are counted: the time from the first block to
+ * the last one, the number of callbacks and the smallest and largest block. */
+
+static int64_t  bench_start_ms;
+static uint32_t bench_callbacks;
+static size_t   bench_bytes;
+static size_t   bench_min_block;
+static size_t   bench_max_block;
+
+static mender_err_t
+bench_update_module_download(MENDER_ARG_UNUSED mender_update_state_t state, mender_update_state_data_t callback_data) {
+    struct mender_update_download_state_data_s *dl_data = callback_data.download_state_data;
+
+    if (NULL == dl_data->filename) {
+        return MENDER_OK;
+    }
+
+    if (0 == dl_data->offset) {
+        bench_start_ms  = k_uptime_get();
+        bench_callbacks = 0;
+        bench_bytes     = 0;
+        bench_min_block = SIZE_MAX;
+        bench_max_block = 0;
+    }
+
+    bench_callbacks++;
+    bench_bytes += dl_data->length;
+    if (dl_data->length > 0) {
+        bench_min_block = MIN(bench_min_block, dl_data->length);
+        bench_max_block = MAX(bench_max_block, dl_data->length);
+    }
+
+    if (dl_data->done) {
+        uint32_t elapsed_ms = MAX((uint32_t)(k_uptime_get() - bench_start_ms), 1);
+        mender_log_info("bench-update: %zu bytes in %u ms (%llu B/s), %u callbacks, blocks %zu..%zu bytes",
+                        bench_bytes,
+                        elapsed_ms,
+                        (unsigned long long)bench_bytes * 1000 / elapsed_ms,
+                        bench_callbacks,
+                        (0 == bench_max_block) ? 0 : bench_min_block,
+                        bench_max_block);
+    }
+
+    return MENDER_OK;
+}
+
+mender_err_t
+bench_update_module_register(void) {
+    mender_err_t            ret;
+    mender_update_module_t *bench_update_module;
+
+    if (NULL == (bench_update_module = mender_calloc(1, sizeof(mender_update_module_t)))) {
+        mender_log_error("Unable to allocate memory for the 'bench-update' update module");
+        return MENDER_FAIL;
+    }
+    bench_update_module->callbacks[MENDER_UPDATE_STATE_DOWNLOAD] = &bench_update_module_download;
+    bench_update_module->artifact_type                           = "bench-update";
+    bench_update_module->requires_reboot                         = false;
+    bench_update_module->supports_rollback                       = false;
+
+    if (MENDER_OK != (ret = mender_update_module_register(bench_update_module))) {
+        mender_log_error("Unable to register the 'bench-update' update module");
+        /* mender_update_module_register() takes ownership if it succeeds */
+        mender_free(bench_update_module);
+        return ret;
+    }
+
+    return MENDER_OK;
+}
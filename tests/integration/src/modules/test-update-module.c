@@ -18,6 +18,7 @@
 #include <mender/utils.h>
 #include <mender/update-module.h>
 
+#include <stdio.h>
 
 #include <zephyr/kernel.h>
 
@@ -48,6 +49,100 @@ static mender_err_t test_update_module_rollback_verify_reboot(mender_update_stat
 #define UM_SUPPORTS_ROLLBACK false
 #endif
 
+/* Set at runtime from the command line, so that one build runs every test: the states to fail in
+ * (BIT(state)), the flags of the module and a sleep in the first download callback */
+static uint32_t test_update_module_fail_states;
+static bool     test_update_module_requires_reboot;
+static bool     test_update_module_supports_rollback;
+static uint32_t test_update_module_download_sleep_s;
+
+static bool
+test_update_module_fails_in(mender_update_state_t state) {
+    if (0 == (test_update_module_fail_states & BIT(state))) {
+        return false;
+    }
+    mender_log_info("test-update: failing in state %d", state);
+    return true;
+}
+
+#ifdef CONFIG_ARCH_POSIX
+#include <string.h>
+
+#include "cmdline.h"
+#include "posix_native_task.h"
+
+static const char *test_update_module_state_names[] = {
+    [MENDER_UPDATE_STATE_DOWNLOAD]               = "download",
+    [MENDER_UPDATE_STATE_INSTALL]                = "install",
+    [MENDER_UPDATE_STATE_REBOOT]                 = "reboot",
+    [MENDER_UPDATE_STATE_VERIFY_REBOOT]          = "verify_reboot",
+    [MENDER_UPDATE_STATE_COMMIT]                 = "commit",
+    [MENDER_UPDATE_STATE_ROLLBACK]               = "rollback",
+    [MENDER_UPDATE_STATE_ROLLBACK_REBOOT]        = "rollback_reboot",
+    [MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT] = "rollback_verify_reboot",
+    [MENDER_UPDATE_STATE_FAILURE]                = "failure",
+};
+
+static char *test_update_module_fail_option;
+
+/* --um-fail=<state>[,<state>...], with the names above */
+static void
+test_update_module_fail_found(char *argv, int offset) {
+    ARG_UNUSED(argv);
+    ARG_UNUSED(offset);
+
+    for (char *name = test_update_module_fail_option; (NULL != name) && ('\0' != *name);) {
+        char  *end = strchr(name, ',');
+        size_t len = (NULL != end) ? (size_t)(end - name) : strlen(name);
+        size_t i;
+
+        for (i = 0; i < ARRAY_SIZE(test_update_module_state_names); i++) {
+            if ((NULL != test_update_module_state_names[i]) && (len == strlen(test_update_module_state_names[i]))
+                && (0 == strncmp(name, test_update_module_state_names[i], len))) {
+                test_update_module_fail_states |= BIT(i);
+                break;
+            }
+        }
+        if (ARRAY_SIZE(test_update_module_state_names) == i) {
+            printk("Unknown state in --um-fail: %.*s\n", (int)len, name);
+        }
+        name = (NULL != end) ? end + 1 : NULL;
+    }
+}
+
+static void
+test_update_module_add_options(void) {
+    static struct args_struct_t test_update_module_options[] = {
+        { .option          = "um-fail",
+          .name            = "states",
+          .type            = 's',
+          .dest            = (void *)&test_update_module_fail_option,
+          .call_when_found = test_update_module_fail_found,
+          .descript        = "Comma separated states the 'test-update' module fails in, e.g. commit,rollback" },
+        { .is_switch = true,
+          .option    = "um-reboot",
+          .type      = 'b',
+          .dest      = (void *)&test_update_module_requires_reboot,
+          .descript  = "The 'test-update' module requires a reboot" },
+        { .is_switch = true,
+          .option    = "um-rollback",
+          .type      = 'b',
+          .dest      = (void *)&test_update_module_supports_rollback,
+          .descript  = "The 'test-update' module supports rollback" },
+        { .option   = "um-download-sleep",
+          .name     = "seconds",
+          .type     = 'u',
+          .dest     = (void *)&test_update_module_download_sleep_s,
+          .descript = "Sleep in the first download callback of the 'test-update' module" },
+        ARG_TABLE_ENDMARKER,
+    };
+
+    native_add_command_line_opts(test_update_module_options);
+}
+
+NATIVE_TASK(test_update_module_add_options, PRE_BOOT_1, 10);
+#endif /* CONFIG_ARCH_POSIX */
+
 mender_err_t
 test_update_module_register(void) {
     mender_err_t            ret;
@@ -68,13 +163,13 @@ test_update_module_register(void) {
     test_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK_REBOOT] = &test_update_module_rollback_reboot;
     test_update_module->callbacks[MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT] = &test_update_module_rollback_verify_reboot;
     test_update_module->artifact_type                                  = "test-update";
-    test_update_module->requires_reboot                                = UM_REQUIRES_REBOOT;
-    test_update_module->supports_rollback                              = UM_SUPPORTS_ROLLBACK;
+    test_update_module->requires_reboot                                = UM_REQUIRES_REBOOT || test_update_module_requires_reboot;
+    test_update_module->supports_rollback                              = UM_SUPPORTS_ROLLBACK || test_update_module_supports_rollback;
 
     if (MENDER_OK != (ret = mender_update_module_register(test_update_module))) {
         mender_log_error("Unable to register the 'test-update' update module");
         /* mender_client_register_update_module() takes ownership if it succeeds */
-        free(test_update_module);
+        mender_free(test_update_module);
         return ret;
     }
 
@@ -83,13 +178,20 @@ test_update_module_register(void) {
 
 static mender_err_t
 test_update_module_download(MENDER_NDEBUG_UNUSED mender_update_state_t state, MENDER_ARG_UNUSED mender_update_state_data_t callback_data) {
+    static bool slept = false;
 
     /* Macro defined by test */
 #ifdef UM_DOWNLOAD_CALLBACK
     UM_DOWNLOAD_CALLBACK();
 #endif
 
-    return MENDER_OK;
+    if ((test_update_module_download_sleep_s > 0) && !slept) {
+        printf("Sleeping in download\n");
+        k_sleep(K_SECONDS(test_update_module_download_sleep_s));
+        slept = true;
+    }
+
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_DOWNLOAD) ? MENDER_FAIL : MENDER_OK;
 }
 
 static mender_err_t
@@ -99,7 +201,8 @@ test_update_module_install(MENDER_NDEBUG_UNUSED mender_update_state_t state, MEN
 #ifdef UM_INSTALL_CALLBACK
     UM_INSTALL_CALLBACK();
 #endif
-    return MENDER_OK;
+
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_INSTALL) ? MENDER_FAIL : MENDER_OK;
 }
 
 static mender_err_t test_update_module_reboot(mender_update_state_t state, mender_update_state_data_t callback_data) {
@@ -108,7 +211,8 @@ static mender_err_t test_update_module_reboot(mender_update_state_t state, mende
 #ifdef UM_REBOOT_CALLBACK
     UM_REBOOT_CALLBACK();
 #endif
-    return MENDER_OK;
+
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_REBOOT) ? MENDER_FAIL : MENDER_OK;
 }
 
 static mender_err_t test_update_module_verify_reboot(mender_update_state_t state, mender_update_state_data_t callback_data) {
@@ -118,7 +222,7 @@ static mender_err_t test_update_module_verify_reboot(mender_update_state_t state
     UM_VERIFY_REBOOT_CALLBACK();
 #endif
 
-    return MENDER_OK;
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_VERIFY_REBOOT) ? MENDER_FAIL : MENDER_OK;
 }
 
 static mender_err_t
@@ -129,7 +233,7 @@ test_update_module_commit(MENDER_NDEBUG_UNUSED mender_update_state_t state, MEND
     UM_COMMIT_CALLBACK();
 #endif
 
-    return MENDER_OK;
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_COMMIT) ? MENDER_FAIL : MENDER_OK;
 }
 
 
@@ -140,7 +244,7 @@ static mender_err_t test_update_module_rollback(mender_update_state_t state, men
     UM_ROLLBACK_CALLBACK();
 #endif
 
-    return MENDER_OK;
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_ROLLBACK) ? MENDER_FAIL : MENDER_OK;
 }
 
 static mender_err_t
@@ -151,7 +255,7 @@ test_update_module_failure(MENDER_NDEBUG_UNUSED mender_update_state_t state, MEN
     UM_FAILURE_CALLBACK();
 #endif
 
-    return MENDER_OK;
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_FAILURE) ? MENDER_FAIL : MENDER_OK;
 }
 
 
@@ -161,7 +265,8 @@ static mender_err_t test_update_module_rollback_reboot(mender_update_state_t sta
 #ifdef UM_ROLLBACK_REBOOT_CALLBACK
     UM_ROLLBACK_REBOOT_CALLBACK();
 #endif
-    return MENDER_OK;
+
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_ROLLBACK_REBOOT) ? MENDER_FAIL : MENDER_OK;
 }
 
 static mender_err_t test_update_module_rollback_verify_reboot(mender_update_state_t state, mender_update_state_data_t callback_data) {
@@ -170,5 +275,6 @@ static mender_err_t test_update_module_rollback_verify_reboot(mender_update_stat
 #ifdef UM_ROLLBACK_VERIFY_REBOOT_CALLBACK
     UM_ROLLBACK_VERIFY_REBOOT_CALLBACK();
 #endif
-    return MENDER_OK;
+
+    return test_update_module_fails_in(MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT) ? MENDER_FAIL : MENDER_OK;
 }
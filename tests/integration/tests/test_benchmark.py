@@ -0,0 +1,36 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import pytest
+import logging
+
+logger = logging.getLogger(__name__)
+
+import benchmark
+
+
+# Only the smaller sizes, the full sweep is run with benchmark.py
+def test_benchmark(server, get_build_dir, request):
+    if not request.config.getoption("--mock-server"):
+        pytest.skip("The benchmark only runs against the mock server")
+
+    server.auto_accept = True
+    report = benchmark.run(server, get_build_dir, sizes=[4 * 1024, 1024 * 1024])
+    logger.info(report)
+
+    for result in report["results"]:
+        assert result["success"], f"Deployment of {result['size']} bytes failed"
+        assert result["bytes"] == result["size"], "Not all the payload reached the Update Module"
+        assert result["callbacks"] > 0
+        assert result["tls_heap_peak"] is not None, "No TLS heap statistics reported"
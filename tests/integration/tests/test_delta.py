@@ -0,0 +1,158 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import os
+import re
+import sys
+import time
+import random
+import subprocess
+import pytest
+import logging
+
+logger = logging.getLogger(__name__)
+
+from helpers import stdout
+from device import NativeSim, WORKSPACE_DIRECTORY
+
+DELTA_PATCH = os.path.join(WORKSPACE_DIRECTORY, "scripts", "delta-patch.py")
+
+# Size of the flash simulator of native_sim
+FLASH_SIZE = 2 * 1024 * 1024
+
+PARTITION_RE = re.compile(
+    r"(slot[01])_partition: partition@[0-9a-f]+ \{[^}]*?reg = <\s*(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s*>"
+)
+APPLIED_RE = re.compile(r"Patch applied, (\d+) bytes written to the target slot")
+
+
+# Offset and size of the MCUboot slots in the devicetree of the build
+def slots(build_dir):
+    with open(os.path.join(build_dir, "zephyr", "zephyr.dts")) as f:
+        dts = f.read()
+    return {
+        name: (int(offset, 16), int(size, 16))
+        for name, offset, size in PARTITION_RE.findall(dts)
+    }
+
+
+def read_slot(flash, slot, length):
+    with open(flash, "rb") as f:
+        f.seek(slot[0])
+        return f.read(length)
+
+
+# What MCUboot does on the reboot of an update in swap mode: the new image, with the
+# trailer requesting the test, goes to the primary slot, the running one to the secondary
+def mcuboot_swap(flash, slot0, slot1):
+    with open(flash, "r+b") as f:
+        f.seek(slot0[0])
+        primary = f.read(slot0[1])
+        f.seek(slot1[0])
+        secondary = f.read(slot1[1])
+        f.seek(slot0[0])
+        f.write(secondary)
+        f.seek(slot1[0])
+        f.write(primary)
+
+
+# A new release: mostly the same image, with changed and added code
+def new_release(image, rnd):
+    image = bytearray(image)
+    for _ in range(32):
+        offset = rnd.randrange(len(image) - 256)
+        length = rnd.randint(1, 256)
+        image[offset : offset + length] = rnd.randbytes(length)
+    return bytes(image) + rnd.randbytes(4096)
+
+
+def make_patch(tmp_path, source, target, name):
+    paths = [tmp_path / f"{name}.{kind}" for kind in ("old", "new", "patch")]
+    paths[0].write_bytes(source)
+    paths[1].write_bytes(target)
+    subprocess.check_call(
+        [sys.executable, DELTA_PATCH, "create"] + [str(path) for path in paths]
+    )
+    return paths[2].read_bytes()
+
+
+def test_delta(server, get_build_dir, tmp_path):
+    rnd = random.Random(0)
+    image = rnd.randbytes(128 * 1024)
+
+    device = NativeSim(get_build_dir, stdout=True)
+    device.set_host(f"https://{server.host}")
+    device.set_tenant(server.get_tenant_token())
+    device.compile(
+        pristine=True, extra_variables=["-DCONFIG_MENDER_APP_DELTA_UPDATE_MODULE=y"]
+    )
+
+    # The running image, as if it had been flashed with MCUboot
+    slot = slots(get_build_dir)
+    slot0, slot1 = slot["slot0"], slot["slot1"]
+    flash = os.path.join(get_build_dir, "flash.bin")
+    with open(flash, "wb") as f:
+        f.write(b"\xff" * FLASH_SIZE)
+        f.seek(slot0[0])
+        f.write(image)
+
+    try:
+        device.start(compile=False)
+        server.accept_device()
+        device.status.is_authenticated(timeout=60)
+
+        # Twice in a row: the second patch is written over the image the first one replaced
+        for release in (1, 2):
+            source = read_slot(flash, slot0, len(image))
+            assert source == image, "The running slot does not hold the image"
+            target = new_release(image, rnd)
+            patch = make_patch(tmp_path, source, target, f"release-{release}")
+            logger.info(
+                f"Release {release}: {len(patch)} bytes patch for {len(target)} bytes"
+            )
+
+            artifact_name = server.upload_artifact(
+                f"test-delta-{release}",
+                device_types=("test-device",),
+                update_module="zephyr-delta",
+                data=patch,
+            )
+            server.create_deployment(artifact_name, server.device_id, True)
+
+            applied = None
+            success = False
+            timeout = 180
+            start_time = time.time()
+            while time.time() - start_time < timeout:
+                line = stdout(device)
+                match = APPLIED_RE.search(line)
+                if match:
+                    applied = int(match.group(1))
+                if "Waiting for a reboot" in line or device.proc.poll() is not None:
+                    device.stop()
+                    mcuboot_swap(flash, slot0, slot1)
+                    device.start(compile=False)
+                if "deployment_status_cb: success" in line:
+                    success = True
+                    break
+                if "deployment_status_cb: failure" in line:
+                    break
+
+            assert success, f"Deployment of release {release} failed"
+            assert applied == len(target)
+            assert read_slot(flash, slot0, len(target)) == target
+            image = target
+    finally:
+        server.abort_deployment()
+        device.stop()
@@ -0,0 +1,43 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import pytest
+import logging
+
+logger = logging.getLogger(__name__)
+
+import fleet
+
+
+def test_fleet(server, get_build_dir, request):
+    if not request.config.getoption("--mock-server"):
+        pytest.skip("The fleet only runs against the mock server")
+
+    interfaces = request.config.getoption("--fleet-interfaces").split(",")
+    server.auto_accept = True
+
+    report = fleet.run(
+        server,
+        get_build_dir,
+        interfaces,
+        duration=180,
+        deploy_after=60,
+        artifact_size=64 * 1024,
+        extra_variables=["-DCONFIG_MENDER_APP_POLL_SCHED=y"],
+    )
+    logger.info(report)
+
+    assert report["authenticated"] == len(interfaces), "Not all the devices authenticated"
+    assert report["devices_polling"] == len(interfaces), "Not all the devices polled"
+    assert sum(report["deployment"].values()) == len(interfaces), "Not all the devices took the deployment"
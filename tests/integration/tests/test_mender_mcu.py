@@ -13,6 +13,7 @@
 #    limitations under the License.
 
 import os
+import re
 import time
 import pytest
 import helpers
@@ -20,38 +21,18 @@ import logging
 
 logger = logging.getLogger(__name__)
 
-from helpers import stdout
-from device import NativeSim
+from helpers import wait_for_line
 
 import definitions
 
 
-def test_deployment_abort(server, get_build_dir):
-
-    artifact_name = server.upload_artifact(
-        "test-artifact", device_types=("test-device",)
-    )
-
-    download_body = r"""
-    static int counter = 0; \
-    if (counter == 0) { \
-        printf("Sleeping in download\n"); \
-        k_sleep(K_SECONDS(5)); \
-    }\
-    counter++; \
-    """
-    helpers.set_callback(definitions.UM_DOWNLOAD_CALLBACK, download_body)
-
-    device = NativeSim(get_build_dir, stdout=True)
-    # Set host and tenant in the device
-    device.set_host("https://hosted.mender.io")
-
-    # Temporary workaround for the PoC
-    device.set_tenant(server.get_tenant_token())
+def test_deployment_abort(server, shared_device, worker_identity):
+    # Sleeps in the first download callback so that the deployment can be aborted meanwhile
+    device = shared_device(run_args=helpers.um_run_args(download_sleep=5))
 
     # Start device
-    device.start(pristine=True)
-    server.accept_device()
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
     device.status.is_authenticated(timeout=60)
 
     artifact_name = server.upload_artifact(
@@ -61,13 +42,8 @@ def test_deployment_abort(server, get_build_dir):
     server.create_deployment(artifact_name, server.device_id, True)
 
     # Wait for download callback to sleep so we can abort
-    timeout = 60
-    start_time = time.time()
-    while time.time() - start_time < timeout:
-        line = stdout(device)
-        if "Sleeping in download\n" in line:
-            server.abort_deployment()
-            break
+    if wait_for_line(device, "Sleeping in download\n"):
+        server.abort_deployment()
 
     if not device.status.is_aborted(timeout=60):
         device.stop()
@@ -75,3 +51,277 @@ def test_deployment_abort(server, get_build_dir):
 
     device.stop()
     logger.info("Deployment aborted")
+
+
+def test_boot_profile(server, shared_device, worker_identity):
+    device = shared_device(extra_variables=("-DCONFIG_MENDER_APP_PROFILER=y",))
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    try:
+        summary = wait_for_line(device, "Boot profile:", timeout=120)
+        assert summary is not None, "No boot profile summary"
+        for phase in (
+            "kernel",
+            "network",
+            "certs",
+            "client_init",
+            "modules",
+            "activate",
+            "authenticated",
+            "first_poll",
+            "total",
+        ):
+            assert f"{phase} " in summary, f"Phase {phase} missing in the boot profile"
+        logger.info(summary)
+    finally:
+        device.stop()
+
+
+def test_network_on_demand(server, shared_device, worker_identity):
+    device = shared_device(
+        extra_variables=("-DCONFIG_MENDER_APP_NETWORK_ON_DEMAND=y",)
+    )
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    try:
+        # The interface must go down between the client's network windows and come back up
+        for cycle in range(2):
+            line = wait_for_line(device, "Network down: on for", timeout=120)
+            assert line, f"The network was not taken down, {cycle} cycles"
+            logger.info(line)
+    finally:
+        device.stop()
+
+
+def test_net_lease_cache(server, shared_device):
+    device = shared_device(extra_variables=("-DCONFIG_MENDER_APP_NET_LEASE_CACHE=y",))
+
+    device.start(compile=False)
+
+    try:
+        assert wait_for_line(device, "Saved DHCP lease"), "The DHCP lease was not saved"
+
+        # The flash is kept: the next boot must be up with the cached address before the DHCP
+        # exchange completes, and the server must bind that same address
+        device.restart()
+        line = wait_for_line(device, "Using cached address")
+        assert line, "The cached lease was not used before DHCP completed"
+        cached = re.search(r"Using cached address (\S+)", line).group(1)
+        line = wait_for_line(device, "DHCP bound to")
+        assert line, "DHCP did not complete"
+        bound = re.search(r"DHCP bound to (\S+)", line).group(1)
+        assert cached == bound, f"Cached {cached}, bound to {bound}"
+        logger.info(f"Up with {cached} before DHCP completed")
+    finally:
+        device.stop()
+
+
+def test_poll_sched(server, shared_device, worker_identity):
+    device = shared_device(
+        extra_variables=(
+            "-DCONFIG_MENDER_APP_POLL_SCHED=y",
+            "-DCONFIG_MENDER_APP_POLL_SCHED_STARTUP_SPREAD=10",
+        )
+    )
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    try:
+        jitter = wait_for_line(device, "Poll jitter:")
+        assert jitter, "No poll jitter derived from the identity"
+        # Only scheduled once a poll has been answered
+        next_poll = wait_for_line(device, "Next poll in", timeout=120)
+        assert next_poll, "The next poll was not scheduled"
+        logger.info(jitter)
+        logger.info(next_poll)
+    finally:
+        device.stop()
+
+
+def test_status_journal(server, shared_device, worker_identity, request):
+    if not request.config.getoption("--mock-server"):
+        pytest.skip("The deployment logs are read from the mock server")
+
+    device = shared_device(
+        run_args=helpers.um_run_args(fail_in=("MENDER_UPDATE_STATE_INSTALL",)),
+        extra_variables=(
+            "-DCONFIG_MENDER_DEPLOYMENT_LOGS=y",
+            "-DCONFIG_MENDER_APP_STATUS_JOURNAL=y",
+        ),
+    )
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    logs = server.devices[worker_identity[0]]["logs"]
+    entry = re.compile(rb"Journal: boot \d+, \d+ s: [\w-]+")
+
+    def journal_of_failed_deployment(name, uploads):
+        artifact_name = server.upload_artifact(name, device_types=("test-device",))
+        server.create_deployment(artifact_name, server.device_id, True)
+        assert wait_for_line(
+            device, "deployment_status_cb: failure", timeout=180
+        ), "The deployment did not fail"
+        start_time = time.time()
+        while len(logs) < uploads and time.time() - start_time < 10:
+            time.sleep(0.5)
+        assert len(logs) == uploads, "No deployment logs uploaded"
+        return set(entry.findall(logs[-1]))
+
+    try:
+        device.status.is_authenticated(timeout=60)
+
+        # The transitions of the failed deployment are delivered with its logs
+        first = journal_of_failed_deployment("test-status-journal-1", 1)
+        logger.info(first)
+        assert any(b": downloading" in line for line in first)
+
+        # Deleted once acknowledged, the next failure only delivers the entries since
+        second = journal_of_failed_deployment("test-status-journal-2", 2)
+        logger.info(second)
+        assert second, "No journal entries delivered"
+        assert not first & second, "Acknowledged entries delivered again"
+    finally:
+        server.abort_deployment()
+        device.stop()
+
+
+def test_event_trace(server, shared_device, worker_identity):
+    device = shared_device(
+        extra_variables=("-DCONFIG_MENDER_APP_EVENT_TRACE=y",), trace=True
+    )
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    try:
+        assert device.status.is_authenticated(timeout=60), "No authentication traced"
+        artifact_name = server.upload_artifact(
+            "test-event-trace", device_types=("test-device",)
+        )
+        server.create_deployment(artifact_name, server.device_id, True)
+
+        trace = device.trace
+        success = definitions.DEPLOYMENT_STATUSES.index("success")
+        index, done = trace.wait_for(
+            lambda event: event.type == definitions.TRACE_DEPLOYMENT_STATUS
+            and event.a == success,
+            timeout=120,
+        )
+        assert done is not None, "The deployment did not succeed"
+
+        # Every update state callback traced returns before the next one is entered
+        states = [
+            event
+            for event in trace.events[:index]
+            if event.type
+            in (definitions.TRACE_UPDATE_STATE_ENTER, definitions.TRACE_UPDATE_STATE_EXIT)
+        ]
+        assert states, "No update state traced"
+        for enter, leave in zip(states[::2], states[1::2]):
+            assert enter.type == definitions.TRACE_UPDATE_STATE_ENTER
+            assert leave.type == definitions.TRACE_UPDATE_STATE_EXIT
+            assert enter.a == leave.a
+            logger.info(
+                f"{definitions.UPDATE_STATES[enter.a]}: {leave.time_us - enter.time_us} us"
+            )
+
+        received = sum(event.a for event in trace.of_type(definitions.TRACE_DOWNLOAD))
+        assert received == 256, f"{received} bytes traced instead of the 256 of the payload"
+        assert trace.dropped == 0, f"{trace.dropped} events dropped"
+
+        downloading = definitions.DEPLOYMENT_STATUSES.index("downloading")
+        _, start = trace.wait_for(
+            lambda event: event.type == definitions.TRACE_DEPLOYMENT_STATUS
+            and event.a == downloading,
+            timeout=0,
+        )
+        if start is not None:
+            logger.info(f"Deployment took {(done.time_us - start.time_us) / 1000} ms")
+    finally:
+        server.abort_deployment()
+        device.stop()
+
+
+def test_auth_cache(server, shared_device, worker_identity, request):
+    mock = request.config.getoption("--mock-server")
+
+    device = shared_device(extra_variables=("-DCONFIG_MENDER_APP_AUTH_CACHE=y",))
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    try:
+        assert wait_for_line(
+            device, "Saved the authentication token"
+        ), "The authentication token was not saved"
+        requests = server.stats.requests["auth"] if mock else None
+
+        # The flash is kept, the next boot must not ask the server
+        device.restart()
+        assert wait_for_line(
+            device, "Authenticated with the saved token"
+        ), "The saved authentication token was not used"
+        assert wait_for_line(
+            device, "Authenticated successfully"
+        ), "The device did not authenticate"
+        if mock:
+            assert server.stats.requests["auth"] == requests
+
+            # A rejected token is dropped, and the client authenticates with the server
+            server.revoke_tokens()
+            device.restart()
+            assert wait_for_line(
+                device, "Dropping the saved authentication token"
+            ), "The rejected token was kept"
+            assert wait_for_line(
+                device, "Saved the authentication token"
+            ), "The device did not authenticate again"
+            assert server.stats.requests["auth"] > requests
+    finally:
+        device.stop()
+
+
+def test_deploy_log(server, shared_device, worker_identity, request):
+    if not request.config.getoption("--mock-server"):
+        pytest.skip("The deployment logs are read from the mock server")
+
+    device = shared_device(
+        run_args=helpers.um_run_args(fail_in=("MENDER_UPDATE_STATE_INSTALL",)),
+        extra_variables=(
+            "-DCONFIG_MENDER_DEPLOYMENT_LOGS=y",
+            "-DCONFIG_MENDER_APP_DEPLOY_LOG=y",
+        ),
+    )
+
+    device.start(compile=False)
+    server.accept_device(worker_identity[0])
+
+    try:
+        device.status.is_authenticated(timeout=60)
+        artifact_name = server.upload_artifact(
+            "test-deploy-log", device_types=("test-device",)
+        )
+        server.create_deployment(artifact_name, server.device_id, True)
+
+        assert wait_for_line(
+            device, "deployment_status_cb: failure", timeout=180
+        ), "The deployment did not fail"
+
+        # The captured lines, from the start of the deployment to the failing Update Module
+        logs = server.devices[worker_identity[0]]["logs"]
+        start_time = time.time()
+        while not logs and time.time() - start_time < 10:
+            time.sleep(0.5)
+        assert logs, "No deployment logs uploaded"
+        uploaded = b"".join(logs)
+        assert b"deployment_status_cb: downloading" in uploaded
+        assert b"test-update: failing in state" in uploaded
+    finally:
+        server.abort_deployment()
+        device.stop()
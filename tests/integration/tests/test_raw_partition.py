@@ -0,0 +1,194 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import os
+import re
+import time
+import random
+import hashlib
+import pytest
+import logging
+
+logger = logging.getLogger(__name__)
+
+from helpers import stdout
+from device import NativeSim
+
+# Offset of raw_partition in boards/native_sim.overlay
+RAW_PARTITION_OFFSET = 0x100000
+
+THROUGHPUT_RE = re.compile(r"raw-partition: wrote (\d+) bytes in (\d+) ms \((\d+) B/s\)")
+DIGEST_RE = re.compile(r"raw-partition: (\d+) bytes, sha256 ([0-9a-f]{64})")
+DECOMPRESS_RE = re.compile(r"Decompressed '[^']+': (\d+) bytes from (\d+) bytes")
+
+
+@pytest.mark.parametrize("compress", [False, True], ids=["plain", "heatshrink"])
+def test_raw_partition(server, get_build_dir, compress):
+    if compress:
+        # Compressible, but not trivially so
+        payload = b"".join(
+            os.urandom(16) * random.randint(1, 64) for _ in range(4096)
+        )[: 256 * 1024 + 123]
+    else:
+        payload = os.urandom(256 * 1024 + 123)
+    extra_variables = [
+        "-DCONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE=y",
+        "-DCONFIG_MENDER_APP_DOWNLOAD_HASH=y",
+    ]
+    if compress:
+        extra_variables.append("-DCONFIG_MENDER_APP_DOWNLOAD_DECOMPRESS=y")
+
+    device = NativeSim(get_build_dir, stdout=True)
+    device.set_host(f"https://{server.host}")
+    device.set_tenant(server.get_tenant_token())
+
+    try:
+        device.start(
+            pristine=True,
+            extra_variables=extra_variables,
+        )
+        server.accept_device()
+        device.status.is_authenticated(timeout=60)
+
+        artifact_name = server.upload_artifact(
+            "test-raw-partition",
+            device_types=("test-device",),
+            update_module="raw-partition",
+            data=payload,
+            compress=compress,
+        )
+        server.create_deployment(artifact_name, server.device_id, True)
+
+        throughput = None
+        decompressed = None
+        digest = None
+        success = False
+        timeout = 180
+        start_time = time.time()
+        while time.time() - start_time < timeout:
+            line = stdout(device)
+            match = THROUGHPUT_RE.search(line)
+            if match:
+                throughput = [int(value) for value in match.groups()]
+            match = DIGEST_RE.search(line)
+            if match:
+                digest = (int(match.group(1)), match.group(2))
+            match = DECOMPRESS_RE.search(line)
+            if match:
+                decompressed = [int(value) for value in match.groups()]
+            if "deployment_status_cb: success" in line:
+                success = True
+                break
+            if "deployment_status_cb: failure" in line:
+                break
+
+        assert success, "Deployment of the raw-partition artifact failed"
+        assert throughput is not None, "No throughput reported by the Update Module"
+        assert throughput[0] == len(payload)
+        assert digest == (len(payload), hashlib.sha256(payload).hexdigest())
+        if compress:
+            assert decompressed is not None, "Payload was not decompressed"
+            assert decompressed[0] == len(payload)
+            assert decompressed[1] < len(payload)
+            logger.info(
+                f"heatshrink: {decompressed[1]} bytes downloaded for {decompressed[0]} bytes"
+            )
+        logger.info(
+            f"raw-partition: {throughput[0]} bytes in {throughput[1]} ms ({throughput[2]} B/s)"
+        )
+    finally:
+        server.abort_deployment()
+        device.stop()
+
+    # The flash simulator keeps the content of the flash in flash.bin
+    with open(os.path.join(get_build_dir, "flash.bin"), "rb") as f:
+        f.seek(RAW_PARTITION_OFFSET)
+        assert f.read(len(payload)) == payload
+
+
+RESUME_RE = re.compile(r"Resuming the download at byte (\d+) of the payload")
+
+
+@pytest.mark.parametrize("reboot", [False, True], ids=["dropped", "rebooted"])
+def test_raw_partition_resume(server, get_build_dir, request, reboot):
+    if not request.config.getoption("--mock-server"):
+        pytest.skip("Dropping downloads needs the mock server")
+
+    payload = os.urandom(384 * 1024 + 123)
+
+    device = NativeSim(get_build_dir, stdout=True)
+    device.set_host(f"https://{server.host}")
+    device.set_tenant(server.get_tenant_token())
+
+    try:
+        device.start(
+            pristine=True,
+            extra_variables=[
+                "-DCONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE=y",
+                "-DCONFIG_MENDER_APP_DOWNLOAD_HASH=y",
+                "-DCONFIG_MENDER_APP_DOWNLOAD_RESUME=y",
+            ],
+        )
+        server.accept_device()
+        device.status.is_authenticated(timeout=60)
+
+        artifact_name = server.upload_artifact(
+            "test-raw-partition-resume",
+            device_types=("test-device",),
+            update_module="raw-partition",
+            data=payload,
+        )
+        # The first attempt loses its connection two thirds into the payload
+        server.cut_downloads(len(payload) * 2 // 3)
+        server.create_deployment(artifact_name, server.device_id, True, retries=1)
+
+        resumed_at = None
+        found = False
+        digest = None
+        success = False
+        timeout = 300
+        start_time = time.time()
+        while time.time() - start_time < timeout:
+            line = stdout(device)
+            if "deployment_status_cb: failure" in line and reboot and not found:
+                device.restart()
+            if "Interrupted download found" in line:
+                found = True
+            match = RESUME_RE.search(line)
+            if match:
+                resumed_at = int(match.group(1))
+            match = DIGEST_RE.search(line)
+            if match:
+                digest = (int(match.group(1)), match.group(2))
+            if "deployment_status_cb: success" in line:
+                success = True
+                break
+
+        assert success, "Deployment of the raw-partition artifact failed"
+        assert not reboot or found, "The download state did not survive the reboot"
+        assert resumed_at is not None, "The download was not resumed"
+        assert 0 < resumed_at <= len(payload) * 2 // 3
+        assert digest == (len(payload), hashlib.sha256(payload).hexdigest())
+
+        # Only the part after the committed data was downloaded again
+        downloads = [start for name, start in server.downloads if name == artifact_name]
+        assert len(downloads) == 2 and downloads[0] == 0 and downloads[1] > resumed_at
+        logger.info(f"Resumed at {resumed_at} of {len(payload)} bytes")
+    finally:
+        server.abort_deployment()
+        device.stop()
+
+    with open(os.path.join(get_build_dir, "flash.bin"), "rb") as f:
+        f.seek(RAW_PARTITION_OFFSET)
+        assert f.read(len(payload)) == payload
@@ -20,25 +20,17 @@ import logging
 
 logger = logging.getLogger(__name__)
 
-import definitions
-
 from helpers import stdout
-from device import NativeSim
 
 
 class TestStateMachineTransitions:
 
-    STATE_TO_CALLBACK = {
-        "MENDER_UPDATE_STATE_DOWNLOAD": definitions.UM_DOWNLOAD_CALLBACK,
-        "MENDER_UPDATE_STATE_INSTALL": definitions.UM_INSTALL_CALLBACK,
-        "MENDER_UPDATE_STATE_REBOOT": definitions.UM_REBOOT_CALLBACK,
-        "MENDER_UPDATE_STATE_VERIFY_REBOOT": definitions.UM_VERIFY_REBOOT_CALLBACK,
-        "MENDER_UPDATE_STATE_COMMIT": definitions.UM_COMMIT_CALLBACK,
-        "MENDER_UPDATE_STATE_ROLLBACK": definitions.UM_ROLLBACK_CALLBACK,
-        "MENDER_UPDATE_STATE_ROLLBACK_REBOOT": definitions.UM_ROLLBACK_REBOOT_CALLBACK,
-        "MENDER_UPDATE_STATE_ROLLBACK_VERIFY_REBOOT": definitions.UM_ROLLBACK_VERIFY_REBOOT_CALLBACK,
-        "MENDER_UPDATE_STATE_FAILURE": definitions.UM_FAILURE_CALLBACK,
-    }
+    # Same build for every test, the Update Module is configured at runtime
+    EXTRA_VARIABLES = (
+        "-DCONFIG_MENDER_HEAP_SIZE=12",
+        "-DCONFIG_MENDER_MAX_STATE_DATA_STORE_COUNT=12",
+        "-DCONFIG_LOG_BACKEND_SHOW_COLOR=n",
+    )
 
     STATE_MACHINE_TEST_SET = {
         "success_no_reboot": {
@@ -309,40 +301,27 @@ class TestStateMachineTransitions:
     FAILED_DEPLOYMENT = "deployment_status_cb: failure"
     SUCCESSFUL_DEPLOYMENT = "deployment_status_cb: success"
 
-    def do_test(self, server, get_build_dir, test_state_set, state_set_key):
-        device = NativeSim(get_build_dir, stdout=True)
-
+    def do_test(self, server, shared_device, worker_identity, test_state_set, state_set_key):
         state_set = test_state_set[state_set_key]
         successful_test = False
         traversed_states = []
 
-        for state in state_set.get("FailureInStates", []):
-            macro = r"""
-            return MENDER_FAIL; \
-            """
-            helpers.set_callback(self.STATE_TO_CALLBACK[state], macro)
-
-        if state_set["RequiresReboot"]:
-            helpers.set_define(definitions.UM_REQUIRES_REBOOT, "true")
-        if state_set["SupportsRollback"]:
-            helpers.set_define(definitions.UM_SUPPORTS_ROLLBACK, "true")
+        device = shared_device(
+            run_args=helpers.um_run_args(
+                fail_in=state_set.get("FailureInStates", []),
+                requires_reboot=state_set["RequiresReboot"],
+                supports_rollback=state_set["SupportsRollback"],
+            ),
+            extra_variables=self.EXTRA_VARIABLES,
+        )
 
         is_noop = state_set_key == "noop_check_deployment"
 
         try:
-            # Set host and tenant in the device
-            device.set_host(f"https://{server.host}")
-            device.set_tenant(server.get_tenant_token())
-
             # Start device
-            extra_variables = [
-                "-DCONFIG_MENDER_HEAP_SIZE=12",
-                "-DCONFIG_MENDER_MAX_STATE_DATA_STORE_COUNT=12",
-                "-DCONFIG_LOG_BACKEND_SHOW_COLOR=n",
-            ]
-            device.start(pristine=True, extra_variables=extra_variables)
+            device.start(compile=False)
 
-            server.accept_device()
+            server.accept_device(worker_identity[0])
             device.status.is_authenticated(timeout=60)
             artifact_name = server.upload_artifact(
                 "test-mender-mcu-state-machine", device_types=("test-device",)
@@ -421,9 +400,17 @@ class TestStateMachineTransitions:
             device.stop()
 
     @pytest.mark.parametrize("state_set", STATE_MACHINE_TEST_SET.keys())
-    def test_state_machine(self, server, get_build_dir, state_set):
-        self.do_test(server, get_build_dir, self.STATE_MACHINE_TEST_SET, state_set)
+    def test_state_machine(self, server, shared_device, worker_identity, state_set):
+        self.do_test(
+            server, shared_device, worker_identity, self.STATE_MACHINE_TEST_SET, state_set
+        )
 
     @pytest.mark.parametrize("state_set", SPONTANEOUS_REBOOT_TEST_SET.keys())
-    def test_spontaneous_reboot(self, server, get_build_dir, state_set):
-        self.do_test(server, get_build_dir, self.SPONTANEOUS_REBOOT_TEST_SET, state_set)
+    def test_spontaneous_reboot(self, server, shared_device, worker_identity, state_set):
+        self.do_test(
+            server,
+            shared_device,
+            worker_identity,
+            self.SPONTANEOUS_REBOOT_TEST_SET,
+            state_set,
+        )
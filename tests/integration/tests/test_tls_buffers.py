@@ -0,0 +1,92 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import os
+import re
+import time
+import pytest
+import logging
+
+logger = logging.getLogger(__name__)
+
+from helpers import stdout
+from device import NativeSim
+
+THROUGHPUT_RE = re.compile(r"raw-partition: wrote (\d+) bytes in (\d+) ms \((\d+) B/s\)")
+HEAP_RE = re.compile(r"TLS heap: peak (\d+) bytes in (\d+) blocks, high-water (\d+) of")
+
+
+# Same download with several record buffer configurations, to see what RAM is saved and what
+# throughput is lost; the results are logged for comparison
+@pytest.mark.parametrize(
+    "max_content_len,variable",
+    [(16384, False), (16384, True), (8192, True)],
+    ids=["16k-fixed", "16k-variable", "8k-variable"],
+)
+def test_tls_buffers(server, get_build_dir, max_content_len, variable):
+    payload = os.urandom(256 * 1024)
+    extra_variables = [
+        "-DCONFIG_MENDER_APP_RAW_PARTITION_UPDATE_MODULE=y",
+        "-DCONFIG_MENDER_APP_TLS_HEAP_STATS=y",
+        f"-DCONFIG_MBEDTLS_SSL_MAX_CONTENT_LEN={max_content_len}",
+    ]
+    if variable:
+        extra_variables.append("-DCONFIG_MENDER_APP_TLS_VARIABLE_BUFFERS=y")
+
+    device = NativeSim(get_build_dir, stdout=True)
+    device.set_host(f"https://{server.host}")
+    device.set_tenant(server.get_tenant_token())
+
+    try:
+        device.start(pristine=True, extra_variables=extra_variables)
+        server.accept_device()
+        device.status.is_authenticated(timeout=60)
+
+        artifact_name = server.upload_artifact(
+            "test-tls-buffers",
+            device_types=("test-device",),
+            update_module="raw-partition",
+            data=payload,
+        )
+        server.create_deployment(artifact_name, server.device_id, True)
+
+        throughput = None
+        peaks = []
+        success = False
+        timeout = 180
+        start_time = time.time()
+        while time.time() - start_time < timeout:
+            line = stdout(device)
+            match = THROUGHPUT_RE.search(line)
+            if match:
+                throughput = [int(value) for value in match.groups()]
+            match = HEAP_RE.search(line)
+            if match:
+                peaks.append(int(match.group(1)))
+            if "deployment_status_cb: success" in line:
+                success = True
+                break
+            if "deployment_status_cb: failure" in line:
+                break
+
+        assert success, "Deployment failed"
+        assert throughput is not None, "No throughput reported by the Update Module"
+        assert peaks, "No TLS heap statistics reported"
+        logger.info(
+            f"{max_content_len} bytes, variable {variable}: {throughput[2]} B/s, "
+            f"TLS heap peak {max(peaks)} bytes over {len(peaks)} connections"
+        )
+    finally:
+        server.abort_deployment()
+        device.stop()
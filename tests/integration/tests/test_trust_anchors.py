@@ -0,0 +1,81 @@
+# Copyright 2025 Northern.tech AS
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import os
+import re
+import time
+import pytest
+import logging
+
+logger = logging.getLogger(__name__)
+
+from helpers import stdout
+from device import NativeSim
+from mock_server import Stats
+
+HEAP_RE = re.compile(r"TLS heap: peak (\d+) bytes .* connected in (\d+) ms")
+
+# Connections measured per build: authentication, inventory and the first poll
+CONNECTIONS = 3
+
+
+def measure(server, get_build_dir, compact):
+    extra_variables = ["-DCONFIG_MENDER_APP_TLS_HEAP_STATS=y"]
+    if compact:
+        extra_variables.append("-DCONFIG_MENDER_APP_COMPACT_TRUST_ANCHORS=y")
+
+    device = NativeSim(get_build_dir, stdout=True)
+    device.set_host(f"https://{server.host}")
+    device.set_tenant(server.get_tenant_token())
+
+    server.stats = Stats()
+    peaks = []
+    connect_ms = []
+    try:
+        device.start(pristine=True, extra_variables=extra_variables)
+        server.accept_device()
+
+        timeout = 120
+        start_time = time.time()
+        while time.time() - start_time < timeout and len(peaks) < CONNECTIONS:
+            line = stdout(device)
+            match = HEAP_RE.search(line)
+            if match:
+                peaks.append(int(match.group(1)))
+                connect_ms.append(int(match.group(2)))
+    finally:
+        device.stop()
+
+    assert len(peaks) == CONNECTIONS, "No TLS heap statistics reported"
+    return {
+        "heap_peak": max(peaks),
+        "connect_ms": sum(connect_ms) / len(connect_ms),
+        "handshake_ms": server.stats.report()["handshake_ms"],
+    }
+
+
+# The same connections with the certificate as is and reduced to a compact anchor
+def test_trust_anchors(server, get_build_dir, request):
+    if not request.config.getoption("--mock-server"):
+        pytest.skip("The handshakes are timed by the mock server")
+
+    before = measure(server, get_build_dir, compact=False)
+    after = measure(server, get_build_dir, compact=True)
+
+    anchor = os.path.join(get_build_dir, "PrimaryTrustAnchor.der")
+    assert os.path.getsize(anchor) < os.path.getsize(server.certificate)
+
+    logger.info(f"Trust anchors, certificate: {before}")
+    logger.info(f"Trust anchors, compact: {after}")
+    assert after["heap_peak"] <= before["heap_peak"]